@@ -0,0 +1,110 @@
+// Depth format benchmark: clears, then draws full-screen quads whose depth test always passes
+// (read + write) or always fails (read only), per DepthFormat at 1080p and 4K. The quads go
+// through the visibility-pass kernel, so the only other traffic is one 4-byte id write per
+// passing pixel; HiZ is off so every pixel really reaches the depth buffer. GB/s counts depth
+// bytes only.
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/gfx/texture.hpp"
+#include "sr/render/raster.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+namespace raster = sr::render::raster;
+using sr::gfx::DepthBuffer;
+using sr::gfx::DepthFormat;
+
+constexpr int kRepeats = 20;
+
+struct Result {
+    double ms = 0.0;
+    double gbps = 0.0;
+};
+
+template <class F> Result time_passes(F&& pass, double bytes_per_pass) {
+    pass(); // warm up
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; ++r)
+        pass();
+    const auto t1 = std::chrono::steady_clock::now();
+    Result res;
+    res.ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / kRepeats;
+    res.gbps = bytes_per_pass / (res.ms * 1e6);
+    return res;
+}
+
+// Two triangles covering the whole target at constant NDC depth `z`.
+void draw_quad(raster::KernelFn kernel, const raster::Target& t, float z) {
+    // Never sampled by an opaque visibility pass, but kernels always have a texture bound.
+    static const sr::gfx::Texture tex(1, 1, std::vector<uint32_t>{0xFFFFFFFFu}, false, 255, 255,
+                                      0.0f);
+    const float w = float(t.width);
+    const float h = float(t.height);
+    const raster::Vertex v00{0.0f, 0.0f, z, 0.0f, 0.0f, 1.0f};
+    const raster::Vertex v10{w, 0.0f, z, 0.0f, 0.0f, 1.0f};
+    const raster::Vertex v01{0.0f, h, z, 0.0f, 0.0f, 1.0f};
+    const raster::Vertex v11{w, h, z, 0.0f, 0.0f, 1.0f};
+    const raster::Rect screen{0, 0, t.width - 1, t.height - 1};
+    raster::State st;
+    st.tex = &tex;
+    st.vis_id = 1;
+    raster::Setup s;
+    if (raster::setup_triangle(v00, v10, v11, screen, s))
+        kernel(s, st, t);
+    if (raster::setup_triangle(v00, v11, v01, screen, s))
+        kernel(s, st, t);
+}
+
+void run(int w, int h, raster::Isa isa) {
+    std::printf("%dx%d (%s)\n", w, h, raster::isa_name(isa));
+    std::printf("  %-6s %4s %16s %16s %16s\n", "format", "B/px", "clear ms  GB/s",
+                "pass ms  GB/s", "fail ms  GB/s");
+
+    std::vector<uint32_t> ids(size_t(w) * size_t(h));
+    const DepthFormat formats[] = {DepthFormat::F32, DepthFormat::D24S8, DepthFormat::D16};
+    for (DepthFormat format : formats) {
+        DepthBuffer zb(w, h, format);
+        raster::Target t;
+        t.ids = ids.data();
+        t.depth = zb.raw();
+        t.depth_format = format;
+        t.width = w;
+        t.height = h;
+        const raster::KernelFn kernel = raster::kernel_for(
+            isa, sr::assets::AlphaMode::Opaque, raster::Pass::Visibility,
+            raster::Sampler::Repeat, format);
+
+        const int bpp = DepthBuffer::bytes_per_pixel(format);
+        const double bytes = double(w) * double(h) * double(bpp);
+        const Result clear = time_passes([&] { zb.clear(); }, bytes);
+        // Each pass clears first so the quad passes again; the clear's time is taken back out.
+        const Result pass_and_clear = time_passes(
+            [&] {
+                zb.clear();
+                draw_quad(kernel, t, 0.0f);
+            },
+            bytes);
+        Result pass;
+        pass.ms = pass_and_clear.ms - clear.ms;
+        pass.gbps = 2.0 * bytes / (pass.ms * 1e6);
+        // Depth is now 0 everywhere, so a quad at 0.5 fails every test.
+        const Result fail = time_passes([&] { draw_quad(kernel, t, 0.5f); }, bytes);
+
+        std::printf("  %-6s %4d %8.3f %7.2f %8.3f %7.2f %8.3f %7.2f\n",
+                    sr::gfx::depth_format_name(format), bpp, clear.ms, clear.gbps, pass.ms,
+                    pass.gbps, fail.ms, fail.gbps);
+    }
+}
+
+} // namespace
+
+int main() {
+    const raster::Isa isa = raster::detect_isa();
+    run(1920, 1080, isa);
+    run(3840, 2160, isa);
+    return 0;
+}
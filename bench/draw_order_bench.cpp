@@ -0,0 +1,155 @@
+// Draw order benchmark: a field of overlapping textured boxes recorded in a shuffled order,
+// submitted through a RenderQueue with sorting off (record order) and on (front to back), from
+// the same cameras. Reports fragments shaded and raster time for both; the difference is what
+// the sorted order saves. The app never renders a frame unsorted just to measure this, so the
+// comparison lives here.
+#include "sr/assets/mesh.hpp"
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/gfx/framebuffer.hpp"
+#include "sr/gfx/texture.hpp"
+#include "sr/math/mat4.hpp"
+#include "sr/render/render_queue.hpp"
+#include "sr/render/renderer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+constexpr int kBoxes = 600;
+constexpr int kTextures = 8;
+constexpr int kViews = 8;
+constexpr int kRepeats = 5;
+
+struct Box {
+    sr::math::Mat4 model;
+    sr::math::Vec3 center;
+    float radius = 0.0f;
+    int tex = 0;
+};
+
+// Unit cube, two triangles per face, counter-clockwise seen from outside.
+sr::assets::Mesh make_cube() {
+    sr::assets::Mesh m;
+    const float n[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    for (const auto& f : n) {
+        const sr::math::Vec3 normal{f[0], f[1], f[2]};
+        const sr::math::Vec3 a = std::abs(f[1]) > 0.5f ? sr::math::Vec3{1, 0, 0}
+                                                       : sr::math::Vec3{0, 1, 0};
+        const sr::math::Vec3 u = sr::math::cross(a, normal);
+        const sr::math::Vec3 v = sr::math::cross(normal, u);
+        const uint32_t base = uint32_t(m.positions.size());
+        const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (const auto& c : corners) {
+            m.positions.push_back((normal + u * c[0] + v * c[1]) * 0.5f);
+            m.uvs.push_back({c[0] * 0.5f + 0.5f, c[1] * 0.5f + 0.5f});
+        }
+        const uint32_t idx[6] = {0, 1, 2, 0, 2, 3};
+        for (uint32_t i : idx)
+            m.indices.push_back(base + i);
+    }
+    return m;
+}
+
+std::vector<sr::gfx::Texture> make_textures() {
+    std::vector<sr::gfx::Texture> out;
+    std::mt19937 rng(1);
+    for (int t = 0; t < kTextures; ++t) {
+        std::vector<uint32_t> px(64 * 64);
+        for (uint32_t& p : px)
+            p = 0xFF000000u | (rng() & 0xFFFFFFu);
+        out.emplace_back(64, 64, std::move(px), false, 255, 255, 0.0f);
+    }
+    return out;
+}
+
+// Boxes spread through a corridor in front of the cameras, in a shuffled record order.
+std::vector<Box> make_boxes() {
+    std::vector<Box> out;
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> x(-12.0f, 12.0f);
+    std::uniform_real_distribution<float> y(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> z(-60.0f, -4.0f);
+    std::uniform_real_distribution<float> size(0.8f, 3.0f);
+    for (int i = 0; i < kBoxes; ++i) {
+        Box b;
+        b.center = {x(rng), y(rng), z(rng)};
+        const float s = size(rng);
+        b.model = sr::math::mul(sr::math::Mat4::translate(b.center),
+                                sr::math::Mat4::scale({s, s, s}));
+        b.radius = 0.87f * s; // half the cube's diagonal
+        b.tex = int(rng() % kTextures);
+        out.push_back(b);
+    }
+    return out;
+}
+
+struct Result {
+    uint64_t fragments = 0;
+    double ms = 0.0;
+};
+
+} // namespace
+
+int main() {
+    sr::gfx::Framebuffer fb(kWidth, kHeight);
+    sr::gfx::DepthBuffer zb(kWidth, kHeight);
+    sr::render::Renderer renderer(fb, zb);
+    sr::render::RenderQueue queue;
+    const sr::assets::Mesh cube = make_cube();
+    const std::vector<sr::gfx::Texture> textures = make_textures();
+    const std::vector<Box> boxes = make_boxes();
+
+    auto frame = [&](const sr::render::Camera& cam) {
+        renderer.clear(0xFF000000u);
+        queue.begin(cam);
+        for (const Box& b : boxes) {
+            sr::render::RenderQueue::Item item;
+            item.mesh = queue.add_mesh(renderer, cube, b.model);
+            item.tex = &textures[size_t(b.tex)];
+            item.index_count = uint32_t(cube.indices.size());
+            queue.push(item, b.center, b.radius);
+        }
+        queue.submit(renderer);
+        return queue.stats().fragments_shaded;
+    };
+
+    Result results[2]; // [sorted]
+    for (int v = 0; v < kViews; ++v) {
+        const float a = 0.15f * float(v);
+        sr::render::Camera cam;
+        cam.eye = {4.0f * std::sin(a), 0.5f, 2.0f};
+        cam.target = {2.0f * std::sin(a), 0.0f, -30.0f};
+        cam.z_far = 200.0f;
+        for (int sorted = 0; sorted < 2; ++sorted) {
+            queue.set_sorting(sorted != 0);
+            frame(cam); // warm up
+            const auto t0 = std::chrono::steady_clock::now();
+            uint64_t fragments = 0;
+            for (int r = 0; r < kRepeats; ++r)
+                fragments = frame(cam);
+            const auto t1 = std::chrono::steady_clock::now();
+            results[sorted].fragments += fragments;
+            results[sorted].ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        }
+    }
+
+    std::printf("%dx%d, %d boxes, %d views\n", kWidth, kHeight, kBoxes, kViews);
+    std::printf("  %-9s %16s %10s\n", "order", "fragments/frame", "ms/frame");
+    const char* names[2] = {"record", "sorted"};
+    for (int sorted = 0; sorted < 2; ++sorted) {
+        std::printf("  %-9s %16llu %10.3f\n", names[sorted],
+                    (unsigned long long)(results[sorted].fragments / kViews),
+                    results[sorted].ms / double(kViews * kRepeats));
+    }
+    const int64_t saved = int64_t(results[0].fragments) - int64_t(results[1].fragments);
+    std::printf("  %-9s %16lld (%.1f%%)\n", "saved", (long long)(saved / kViews),
+                results[0].fragments ? 100.0 * double(saved) / double(results[0].fragments) : 0.0);
+    return 0;
+}
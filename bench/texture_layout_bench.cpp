@@ -0,0 +1,128 @@
+// Texel layout benchmark: samples a large texture along screen rows whose UVs run along u, along
+// v and diagonally, once per layout. Time per sample stands in for cache behaviour; run it under
+// `perf stat -e cache-references,cache-misses` to see the miss rates directly. First checks that
+// sample_repeat_pow2() picks sample_repeat()'s texel over a sweep of UVs.
+#include "sr/gfx/texture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kTexSize = 2048; // 16 MiB, well past L2
+constexpr int kScreenW = 720;
+constexpr int kScreenH = 480;
+constexpr int kRepeats = 8;
+
+sr::gfx::Texture make_texture(int w = kTexSize, int h = kTexSize) {
+    std::vector<uint32_t> px(size_t(w) * size_t(h));
+    std::mt19937 rng(1234);
+    for (uint32_t& p : px)
+        p = rng() | 0xFF000000u;
+    return sr::gfx::Texture(w, h, std::move(px), false, 255, 255, 0.0f);
+}
+
+// Coordinates for a texture side of `size`: a uniform walk over [-2, 2) plus every texel
+// boundary k / (size - 1), one period either side, and its float neighbours.
+std::vector<float> sweep(int size) {
+    std::vector<float> out;
+    for (int i = 0; i < 64 * size; ++i)
+        out.push_back(-2.0f + 4.0f * float(i) / float(64 * size));
+    for (int k = 0; k <= size; ++k) {
+        for (int period = -1; period <= 1; ++period) {
+            const float t = float(period) + float(k) / float(std::max(size - 1, 1));
+            out.push_back(std::nextafter(t, -4.0f));
+            out.push_back(t);
+            out.push_back(std::nextafter(t, 4.0f));
+        }
+    }
+    return out;
+}
+
+// Samples where sample_repeat_pow2() and sample_repeat() disagree, over every level of `tex`.
+// Each sweep runs along one axis, paired with the other axis' sweep.
+int pow2_mismatches(const sr::gfx::Texture& tex) {
+    int bad = 0;
+    for (int l = 0; l < tex.level_count(); ++l) {
+        const std::vector<float> us = sweep(tex.level(l).width);
+        const std::vector<float> vs = sweep(tex.level(l).height);
+        for (size_t i = 0; i < us.size(); ++i) {
+            const float v = vs[i % vs.size()];
+            bad += tex.sample_repeat_pow2(us[i], v, l) != tex.sample_repeat(us[i], v, l);
+        }
+        for (size_t i = 0; i < vs.size(); ++i) {
+            const float u = us[i % us.size()];
+            bad += tex.sample_repeat_pow2(u, vs[i], l) != tex.sample_repeat(u, vs[i], l);
+        }
+    }
+    return bad;
+}
+
+// Screen pixel (x, y) maps to texels rotated by `angle`, one texel per pixel.
+double run(const sr::gfx::Texture& tex, float angle, uint32_t& checksum) {
+    const float s = 1.0f / float(kTexSize);
+    const float dudx = std::cos(angle) * s;
+    const float dvdx = std::sin(angle) * s;
+    const float dudy = -dvdx;
+    const float dvdy = dudx;
+
+    uint32_t sum = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; ++r) {
+        for (int y = 0; y < kScreenH; ++y) {
+            // Offset each repeat so the walk does not just replay a warm cache.
+            float u = 0.37f * float(r) + dudy * float(y);
+            float v = 0.11f * float(r) + dvdy * float(y);
+            for (int x = 0; x < kScreenW; ++x) {
+                sum += tex.sample_repeat(u, v);
+                u += dudx;
+                v += dvdx;
+            }
+        }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    checksum = sum;
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    return ns / (double(kRepeats) * kScreenW * kScreenH);
+}
+
+} // namespace
+
+int main() {
+    sr::gfx::Texture checked = make_texture(kTexSize, kTexSize / 4);
+    checked.build_mips();
+    int bad = pow2_mismatches(checked);
+    checked.set_layout(sr::gfx::TexelLayout::Tiled);
+    bad += pow2_mismatches(checked);
+    std::printf("pow2 sampler: %d mismatches%s\n\n", bad, bad ? "  (MISMATCH)" : "");
+
+    sr::gfx::Texture linear = make_texture();
+    sr::gfx::Texture tiled = make_texture();
+    tiled.set_layout(sr::gfx::TexelLayout::Tiled);
+
+    struct Walk {
+        const char* name;
+        float angle;
+    };
+    const Walk walks[] = {
+        {"along u", 0.0f},
+        {"along v", 1.5707964f},
+        {"diagonal", 0.7853982f},
+    };
+
+    std::printf("%-10s %12s %12s\n", "walk", "linear ns", "tiled ns");
+    for (const Walk& w : walks) {
+        uint32_t sum_linear = 0;
+        uint32_t sum_tiled = 0;
+        const double ns_linear = run(linear, w.angle, sum_linear);
+        const double ns_tiled = run(tiled, w.angle, sum_tiled);
+        std::printf("%-10s %12.2f %12.2f%s\n", w.name, ns_linear, ns_tiled,
+                    sum_linear == sum_tiled ? "" : "  (MISMATCH)");
+    }
+    return 0;
+}
@@ -1,14 +1,43 @@
 #pragma once
 
+#include "sr/gfx/depthbuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
 namespace app {
 
 struct AppConfig {
     int window_w = 1280;
     int window_h = 720;
 
-    // Crunchy internal render resolution (scaled up to window).
+    // Crunchy internal render resolution (scaled up to window). With dynamic resolution this is
+    // the largest size; buffers are allocated at it once.
     int render_w = 720;
     int render_h = 480;
+    // Dynamic resolution: shrink the render size (down to min_render_scale per axis) to keep
+    // raster time near this budget. 0 keeps render_w x render_h.
+    float raster_budget_ms = 0.0f;
+    float min_render_scale = 0.5f;
+
+    // Raster worker lanes (0 = one per hardware thread, 1 = serial immediate-mode raster).
+    int render_threads = 0;
+    // Use the SSE4.1/AVX2 raster kernels when the CPU has them (scalar otherwise).
+    bool simd = true;
+    // Deferred texturing: raster ids + depth first, then sample each visible pixel once.
+    bool vis_buffer = false;
+    // Store textures in 4x4 texel tiles instead of rows (see sr::gfx::TexelLayout).
+    bool tiled_textures = false;
+    // Z-buffer storage (see sr::gfx::DepthFormat for the precision/bandwidth trade-off).
+    sr::gfx::DepthFormat depth_format = sr::gfx::DepthFormat::F32;
+    // Render straight into the locked SDL texture instead of copying the frame into it.
+    bool direct_present = true;
+    // Rasterize on a render thread while the main thread simulates the next frame and presents
+    // the previous one (see FramePipeline); off runs the stages back to back.
+    bool pipelined = true;
+    // Rasterize one field (every other row, alternating per frame) and rebuild the other rows from
+    // the previous frame by reprojection (see sr::render::reconstruct_field).
+    bool interlaced = false;
 };
 
 struct AppToggles {
@@ -18,6 +47,11 @@ struct AppToggles {
     bool castle_double_sided = false;
     bool gravity_enabled = true;
     bool show_fps = true;
+    bool sort_draws = true; // front-to-back opaque / back-to-front blend draw order
+    bool bilinear = false;  // filter every material bilinearly (off: each material's own filter)
+    bool reverse_z = true;  // sr::math::DepthMapping::ReverseZ (off: OpenGL-style depth)
+    // Skip meshes hidden behind last frame's depth (sr::render::OcclusionCuller).
+    bool occlusion_cull = true;
 };
 
 struct FpsCounter {
@@ -36,4 +70,53 @@ struct FpsCounter {
     }
 };
 
+// Picks the render size inside max_w x max_h from measured raster time. Cost is roughly linear in
+// pixel count, so each adjustment scales both axes by sqrt(budget / measured), a step at a time.
+struct DynamicResolution {
+    static constexpr int kWindow = 8; // frames averaged per decision
+
+    float budget_ms = 0.0f; // 0 = always max size
+    float min_scale = 0.5f;
+    int max_w = 0;
+    int max_h = 0;
+    float scale = 1.0f;
+    float raster_ms = 0.0f; // average of the last window
+
+    float accum_ms = 0.0f;
+    int frames = 0;
+
+    void update(float ms) {
+        accum_ms += ms;
+        frames += 1;
+        if (frames < kWindow)
+            return;
+        raster_ms = accum_ms / float(frames);
+        accum_ms = 0.0f;
+        frames = 0;
+        if (budget_ms <= 0.0f)
+            return;
+        // Leave the size alone between 85% and 100% of the budget so it does not oscillate.
+        if (raster_ms > budget_ms || raster_ms < budget_ms * 0.85f) {
+            const float step = std::sqrt(budget_ms * 0.92f / std::max(raster_ms, 0.01f));
+            scale = std::clamp(scale * std::clamp(step, 0.8f, 1.1f), min_scale, 1.0f);
+        }
+    }
+
+    // Rounded down to whole 8x8 HiZ tiles below the max size.
+    int width() const { return scaled(max_w); }
+    int height() const { return scaled(max_h); }
+    int scaled(int max) const {
+        if (budget_ms <= 0.0f || scale >= 1.0f)
+            return max;
+        return std::min(max, std::max(8, int(float(max) * scale) / 8 * 8));
+    }
+};
+
+// Input sampled -> frame presented, over the last second of presented frames.
+struct FrameLatency {
+    float avg_ms = 0.0f;
+    float max_ms = 0.0f;
+    int depth = 1; // frames that can be in flight (1 = not pipelined)
+};
+
 } // namespace app
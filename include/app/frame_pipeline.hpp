@@ -0,0 +1,122 @@
+#pragma once
+
+#include "app/app_types.hpp"
+#include "app/render.hpp"
+
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/gfx/framebuffer.hpp"
+#include "sr/platform/worker_pool.hpp"
+#include "sr/render/occlusion.hpp"
+#include "sr/render/render_queue.hpp"
+#include "sr/render/renderer.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace app {
+
+// Overlaps the frame stages: while the render thread rasterizes frame N, the main thread
+// simulates frame N+1 and presents frame N-1. SDL wants textures locked and presented on the
+// thread that created the renderer, so sim and present share the main thread.
+//
+// Each in-flight frame owns a slot: snapshot, framebuffer, depth buffer, renderer, queue and
+// streaming texture, so no stage touches another's memory. At most kMaxInFlight frames are
+// submitted but not presented, which bounds input latency to that many frames.
+//
+// Per frame, on the main thread: acquire() -> fill the snapshot -> submit() -> present().
+//
+// Dynamic resolution (AppConfig::raster_budget_ms) picks each frame's size at acquire() from the
+// raster times of presented frames; slots keep their max-size buffers and textures and render
+// into the top-left sub-rectangle, which present scales to the window.
+//
+// Interlaced (AppConfig::interlaced), a slot's renderer draws one field into `field` (half the
+// rows, alternating parity per frame) and the render stage rebuilds the full frame into `fb` from
+// it and the previous frame's history, before the HUD goes on top.
+class FramePipeline {
+  public:
+    static constexpr int kMaxInFlight = 2;
+
+    // `pool` (may be null) is only ever used by the stage that rasterizes.
+    FramePipeline(SDL_Renderer* sdl_renderer, const AppConfig& cfg, sr::platform::WorkerPool* pool);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // False if a slot's texture could not be created.
+    bool ok() const { return ok_; }
+
+    // A free slot's snapshot for the next frame (presents older frames if none is free).
+    FrameSnapshot& acquire(int window_w, int window_h);
+    // Hands the acquired frame to the render stage (rendered inline when not pipelined).
+    void submit();
+    // Presents finished frames in order, then waits until fewer than kMaxInFlight are pending.
+    void present(int window_w, int window_h);
+
+    const FrameLatency& latency() const { return latency_; }
+    const DynamicResolution& resolution() const { return resolution_; }
+
+  private:
+    struct Slot {
+        explicit Slot(const AppConfig& cfg);
+
+        sr::gfx::Framebuffer fb;
+        sr::gfx::Framebuffer field; // interlaced: the renderer's target (1x1 otherwise)
+        sr::gfx::DepthBuffer zb;
+        sr::render::Renderer renderer;
+        sr::render::RenderQueue queue;
+        SDL_Texture* screen = nullptr;
+        FrameSnapshot snap;
+        int width = 0; // render size picked at acquire()
+        int height = 0;
+        float raster_ms = 0.0f; // written by the render stage
+        bool ready = false;     // rendered, waiting to be presented (guarded by mu_)
+    };
+
+    void render_slot(Slot& s);
+    void render_main();
+    void present_oldest(int window_w, int window_h);
+    void record_latency(std::chrono::steady_clock::time_point input_time);
+
+    SDL_Renderer* sdl_renderer_ = nullptr;
+    bool direct_present_ = false;
+    bool interlaced_ = false;
+    bool ok_ = true;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::vector<Slot*> free_;   // main thread only
+    Slot* filling_ = nullptr;   // acquired, not yet submitted
+    std::deque<Slot*> pending_; // submitted, not yet presented, oldest first (main thread only)
+
+    std::thread render_thread_; // not started when not pipelined
+    std::mutex mu_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Slot*> work_;
+    bool stop_ = false;
+
+    // Render stage only. Frames reach it in order, so it can carry state from one to the next:
+    // last frame's depth for occlusion culling, and the last reconstructed frame (without HUD)
+    // with its camera.
+    sr::render::OcclusionCuller occlusion_;
+    sr::platform::WorkerPool* pool_ = nullptr;
+    sr::gfx::Framebuffer history_;
+    sr::math::Mat4 history_view_proj_ = sr::math::Mat4::identity();
+    bool have_history_ = false;
+    int field_parity_ = 0;
+
+    FrameLatency latency_;
+    DynamicResolution resolution_;
+    std::chrono::steady_clock::time_point window_start_{};
+    double window_sum_ms_ = 0.0;
+    float window_max_ms_ = 0.0f;
+    int window_frames_ = 0;
+};
+
+} // namespace app
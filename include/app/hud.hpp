@@ -3,9 +3,13 @@
 #include "app/app_types.hpp"
 
 #include "sr/gfx/framebuffer.hpp"
+#include "sr/render/occlusion.hpp"
+#include "sr/render/render_queue.hpp"
 
 namespace app {
 
-void hud_draw(sr::gfx::Framebuffer& fb, const AppToggles& toggles, const FpsCounter& fps);
+void hud_draw(sr::gfx::Framebuffer& fb, const AppToggles& toggles, const FpsCounter& fps,
+              const sr::render::RenderQueue::Stats& stats, const FrameLatency& latency,
+              const DynamicResolution& res, const sr::render::OcclusionCuller::Stats& occlusion);
 
 } // namespace app
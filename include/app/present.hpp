@@ -6,7 +6,14 @@
 
 namespace app {
 
-void upload_framebuffer(SDL_Texture* screen, const sr::gfx::Framebuffer& fb);
+// Zero-copy present: locks the streaming texture and wraps `fb` around it, so the frame renders
+// straight into the texture. Returns false (fb keeps its own pixels) when the lock fails or the
+// texture's pitch is not usable as a Framebuffer stride; the frame then goes through the copy.
+// Every frame must clear the whole framebuffer: locked texture memory starts undefined.
+bool begin_direct_frame(SDL_Texture* screen, sr::gfx::Framebuffer& fb);
+// Ends the frame: unlocks after begin_direct_frame() succeeded, otherwise copies fb row by row.
+void upload_framebuffer(SDL_Texture* screen, sr::gfx::Framebuffer& fb);
+// Scales the top-left src_w x src_h of `screen` to the window, letterboxed.
 void present_texture(SDL_Renderer* renderer, SDL_Texture* screen, int window_w, int window_h,
                      int src_w, int src_h);
 
@@ -3,14 +3,41 @@
 #include "app/app_types.hpp"
 #include "app/game.hpp"
 
+#include "sr/assets/model.hpp"
 #include "sr/gfx/framebuffer.hpp"
+#include "sr/render/occlusion.hpp"
+#include "sr/render/render_queue.hpp"
 #include "sr/render/renderer.hpp"
+#include "sr/scene/scene.hpp"
 
 #include <SDL2/SDL.h>
 
+#include <chrono>
+#include <memory>
+
 namespace app {
 
-void render_game(sr::render::Renderer& renderer, sr::gfx::Framebuffer& fb, Game& g,
-                 const AppToggles& toggles, FpsCounter* fps);
+// Everything rendering reads for one frame, copied out of Game after the sim step. It stays
+// untouched until the frame is presented, so the next sim step can run meanwhile.
+struct FrameSnapshot {
+    sr::scene::Scene scene; // the animated player entity points at `skinned`
+    std::shared_ptr<sr::assets::Model> castle;
+    AppToggles toggles;
+    FpsCounter fps;
+    FrameLatency latency;         // latest measurement, for the HUD
+    DynamicResolution resolution; // as of acquire(), for the HUD
+    std::chrono::steady_clock::time_point input_time;
+
+    // Copy of the skinned player model (skinning rewrites positions in place every step).
+    std::shared_ptr<sr::assets::Model> skinned;
+    const sr::assets::Model* skinned_source = nullptr;
+};
+
+// Reuses `out`'s buffers; after the first frame only the skinned positions are copied.
+void snapshot_game(const Game& g, const AppToggles& toggles, FrameSnapshot& out);
+
+// `occlusion` carries last frame's depth; frames must be rendered through it in order.
+void render_game(sr::render::Renderer& renderer, sr::render::RenderQueue& queue,
+                 sr::render::OcclusionCuller& occlusion, const FrameSnapshot& snap);
 
 } // namespace app
@@ -14,10 +14,14 @@ class AssetStore {
   public:
     explicit AssetStore(SDL_Renderer* renderer) : renderer_(renderer) {}
 
+    // Layout for textures loaded from now on (cached textures keep theirs).
+    void set_texel_layout(sr::gfx::TexelLayout layout) { layout_ = layout; }
+
     std::shared_ptr<sr::gfx::Texture> get_texture(const std::string& path);
 
   private:
     SDL_Renderer* renderer_ = nullptr;
+    sr::gfx::TexelLayout layout_ = sr::gfx::TexelLayout::Linear;
     std::unordered_map<std::string, std::weak_ptr<sr::gfx::Texture>> textures_;
 };
 
@@ -17,6 +17,11 @@ enum class AlphaMode : uint8_t {
     Blend = 2, // alpha blend
 };
 
+enum class TextureFilter : uint8_t {
+    Nearest = 0,
+    Linear = 1, // bilinear within the mip level
+};
+
 struct Material {
     std::string name;
     sr::math::Vec3 base_color{1.0f, 1.0f, 1.0f};
@@ -24,6 +29,7 @@ struct Material {
 
     AlphaMode alpha_mode = AlphaMode::Opaque;
     float alpha_cutoff = 0.5f; // Only used for Mask.
+    TextureFilter filter = TextureFilter::Nearest;
 
     bool double_sided = false;
     bool front_face_ccw = true;
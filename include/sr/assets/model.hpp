@@ -4,15 +4,63 @@
 #include "sr/assets/mesh.hpp"
 #include "sr/math/vec3.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <vector>
 
 namespace sr::assets {
 
+// A run of up to kMaxTriangles consecutive triangles of one primitive, culled as a unit below
+// the primitive level (see build_clusters()). Everything is in model space.
+struct Cluster {
+    static constexpr uint32_t kMaxTriangles = 64;
+
+    uint32_t index_offset = 0; // into Mesh::indices, inside its primitive's range
+    uint32_t index_count = 0;
+    uint32_t vertex_offset = 0; // into Model::cluster_vertices: the vertices its indices use
+    uint32_t vertex_count = 0;
+
+    sr::math::Vec3 bounds_center{0.0f, 0.0f, 0.0f};
+    float bounds_radius = 0.0f;
+
+    // Normal cone of the counter-clockwise triangle normals: each lies within the half-angle
+    // whose sine/cosine are cone_sin/cone_cos of `cone_axis`. cone_cos <= 0 means no useful cone.
+    sr::math::Vec3 cone_axis{0.0f, 0.0f, 1.0f};
+    float cone_sin = 1.0f;
+    float cone_cos = 0.0f;
+
+    // True when every triangle faces away from `eye` (model space), so backface culling would
+    // drop them all. `front_ccw` is the winding that faces the viewer; pass it inverted for
+    // transforms that mirror the model.
+    bool backfacing(const sr::math::Vec3& eye, bool front_ccw) const {
+        if (cone_cos <= 0.0f)
+            return false;
+        // The front normals must all point away: min over the cone of dot(n, centre - eye) has
+        // to exceed the radius. With v = centre - eye at angle b to the axis, that minimum is
+        // |v| cos(b + a) for the cone half-angle a.
+        const sr::math::Vec3 v = front_ccw ? bounds_center - eye : eye - bounds_center;
+        const float len = sr::math::length(v);
+        if (len <= bounds_radius)
+            return false;
+        const float cos_b = sr::math::dot(cone_axis, v) / len;
+        const float sin_b = std::sqrt(std::max(0.0f, 1.0f - cos_b * cos_b));
+        return cos_b * cone_cos - sin_b * cone_sin > bounds_radius / len + 1e-3f;
+    }
+};
+
 struct Primitive {
     uint32_t index_offset = 0;
     uint32_t index_count = 0;
     uint32_t material_index = 0;
+
+    // Bounds of the primitive's triangles in model space (see compute_primitive_bounds()).
+    sr::math::Vec3 bounds_center{0.0f, 0.0f, 0.0f};
+    float bounds_radius = 0.0f;
+
+    // Model::clusters covering the index range in order; none until build_clusters().
+    uint32_t cluster_offset = 0;
+    uint32_t cluster_count = 0;
 };
 
 struct Model {
@@ -23,6 +71,23 @@ struct Model {
     // Bounds in model space.
     sr::math::Vec3 bounds_center{0.0f, 0.0f, 0.0f};
     float bounds_radius = 1.0f;
+
+    // Per-primitive clusters (empty for models whose vertices move, e.g. skinned ones: the bounds
+    // and cones describe the positions at load time).
+    std::vector<Cluster> clusters;
+    std::vector<uint32_t> cluster_vertices;
 };
 
+// Fills each primitive's bounds sphere from the vertices its indices reference. Loaders call this
+// once the mesh and primitive list are final.
+void compute_primitive_bounds(Model& model);
+
+// Splits each primitive into clusters of up to Cluster::kMaxTriangles triangles (drawing a
+// primitive's clusters in order draws exactly what the primitive does), with their bounds
+// sphere, normal cone and vertex list. To keep clusters compact and their cones narrow, the
+// triangles of non-blended primitives are first reordered by facing and position (blended ones
+// composite in index order, so theirs stay), and vertices are renumbered in order of first use.
+// Static-mesh loaders call this after compute_primitive_bounds().
+void build_clusters(Model& model);
+
 } // namespace sr::assets
@@ -8,6 +8,8 @@
 
 namespace sr::assets {
 
-sr::gfx::Texture load_texture_rgba8888(SDL_Renderer* renderer, const std::string& path);
+// Loads `path` as ARGB8888 and builds its mip chain, stored in `layout`.
+sr::gfx::Texture load_texture_rgba8888(SDL_Renderer* renderer, const std::string& path,
+                                       sr::gfx::TexelLayout layout = sr::gfx::TexelLayout::Linear);
 
 } // namespace sr::assets
@@ -1,30 +1,246 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <vector>
 
 namespace sr::gfx {
 
+// Per-pixel depth storage. Depth is NDC z in [-1, 1] (smaller is closer); the unorm formats
+// store d = z * 0.5 + 0.5 rounded to their grid, and every format compares with `<`.
+//
+// - F32: 4 bytes. Exact plane values; the cleared value is +inf, so anything passes.
+// - D24S8: 4 bytes, depth in the high 24 bits, 8 stencil bits below (cleared to 0 and kept by
+//   depth writes). Steps of 2^-24 in d: after the perspective divide that is still far finer
+//   than a pixel's depth range for any sane near plane; same bandwidth as F32.
+// - D16: 2 bytes, half the clear/test/write traffic. Steps of 2^-16 in d; with the standard
+//   projection most of that range is spent near the camera, so distant surfaces closer than
+//   ~far^2 / (near * 65536) apart can z-fight.
+// Unorm formats clear to 1.0 (the far plane), so fragments at exactly z = 1 fail the test.
+// Reverse-Z projections (sr::math::DepthMapping) only use z in [-1, 0]; the unorm grids are
+// uniform, so they lose a bit there and only F32 gains precision from it.
+enum class DepthFormat : uint8_t {
+    F32 = 0,
+    D24S8 = 1,
+    D16 = 2,
+};
+
+inline const char* depth_format_name(DepthFormat format) {
+    switch (format) {
+    case DepthFormat::D24S8:
+        return "d24s8";
+    case DepthFormat::D16:
+        return "d16";
+    case DepthFormat::F32:
+    default:
+        return "f32";
+    }
+}
+
+// Z-buffer plus a coarse hierarchical-Z layer: one conservative max depth per 8x8 tile, kept as
+// float NDC z whatever the storage format. The tile value is never below the real max of its
+// pixels, so "z >= tile max" proves the whole tile hides a fragment without touching per-pixel
+// depth.
 class DepthBuffer {
   public:
-    DepthBuffer(int w, int h)
-        : width_(w), height_(h), z_(w * h, std::numeric_limits<float>::infinity()) {}
+    static constexpr int kHizTile = 8;
+    static constexpr uint32_t kMax24 = (1u << 24) - 1;
+    static constexpr uint32_t kMax16 = (1u << 16) - 1;
+
+    DepthBuffer(int w, int h, DepthFormat format = DepthFormat::F32)
+        : width_(w), height_(h), max_w_(w), max_h_(h), format_(format),
+          hiz_w_((w + kHizTile - 1) / kHizTile),
+          hiz_h_((h + kHizTile - 1) / kHizTile),
+          hiz_(hiz_w_ * hiz_h_, std::numeric_limits<float>::infinity()) {
+        switch (format_) {
+        case DepthFormat::F32:
+            z_.assign(size_t(w) * size_t(h), std::numeric_limits<float>::infinity());
+            break;
+        case DepthFormat::D24S8:
+            d24s8_.assign(size_t(w) * size_t(h), kMax24 << 8);
+            break;
+        case DepthFormat::D16:
+            d16_.assign(size_t(w) * size_t(h), uint16_t(kMax16));
+            break;
+        }
+    }
 
     int width() const { return width_; }
     int height() const { return height_; }
+    DepthFormat format() const { return format_; }
+
+    // Re-lays the storage out as w x h (rows width() apart) within the size it was built with; no
+    // reallocation. Contents are undefined until the next clear(). Fails when w x h does not fit.
+    bool resize(int w, int h) {
+        if (w <= 0 || h <= 0 || w > max_w_ || h > max_h_)
+            return false;
+        width_ = w;
+        height_ = h;
+        hiz_w_ = (w + kHizTile - 1) / kHizTile;
+        hiz_h_ = (h + kHizTile - 1) / kHizTile;
+        const size_t n = size_t(w) * size_t(h);
+        switch (format_) {
+        case DepthFormat::F32:
+            z_.resize(n);
+            break;
+        case DepthFormat::D24S8:
+            d24s8_.resize(n);
+            break;
+        case DepthFormat::D16:
+            d16_.resize(n);
+            break;
+        }
+        hiz_.resize(size_t(hiz_w_) * size_t(hiz_h_));
+        return true;
+    }
+    static int bytes_per_pixel(DepthFormat format) { return format == DepthFormat::D16 ? 2 : 4; }
+
+    // NDC z to the unorm grids and back. The raster kernels (and their SIMD lanes) encode with
+    // exactly these operations, so every path agrees on the stored value. The final min() is
+    // for 24 bits, where max + 0.5 rounds up to 2^24 in float.
+    static uint32_t to_unorm(float z, uint32_t max) {
+        float d = z * 0.5f + 0.5f;
+        d = d > 0.0f ? d : 0.0f;
+        d = d < 1.0f ? d : 1.0f;
+        const uint32_t q = uint32_t(d * float(max) + 0.5f);
+        return q < max ? q : max;
+    }
+    static float from_unorm(uint32_t q, uint32_t max) {
+        return float(q) / float(max) * 2.0f - 1.0f;
+    }
 
     void clear(float v = std::numeric_limits<float>::infinity()) {
-        std::fill(z_.begin(), z_.end(), v);
+        switch (format_) {
+        case DepthFormat::F32:
+            std::fill(z_.begin(), z_.end(), v);
+            break;
+        case DepthFormat::D24S8:
+            std::fill(d24s8_.begin(), d24s8_.end(), to_unorm(v, kMax24) << 8);
+            break;
+        case DepthFormat::D16:
+            std::fill(d16_.begin(), d16_.end(), uint16_t(to_unorm(v, kMax16)));
+            break;
+        }
+        std::fill(hiz_.begin(), hiz_.end(), v);
+    }
+
+    // clear() of [x0, x1) x [y0, y1), clamped to the buffer. HiZ tiles the rect covers (up to the
+    // buffer edge) are reset to `v`; partly covered ones only rise to it, staying conservative.
+    void clear_rect(int x0, int y0, int x1, int y1,
+                    float v = std::numeric_limits<float>::infinity()) {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, width_);
+        y1 = std::min(y1, height_);
+        if (x0 >= x1 || y0 >= y1)
+            return;
+        for (int y = y0; y < y1; ++y) {
+            const size_t i = size_t(y) * size_t(width_) + size_t(x0);
+            const size_t n = size_t(x1 - x0);
+            switch (format_) {
+            case DepthFormat::F32:
+                std::fill_n(z_.begin() + i, n, v);
+                break;
+            case DepthFormat::D24S8:
+                std::fill_n(d24s8_.begin() + i, n, to_unorm(v, kMax24) << 8);
+                break;
+            case DepthFormat::D16:
+                std::fill_n(d16_.begin() + i, n, uint16_t(to_unorm(v, kMax16)));
+                break;
+            }
+        }
+        for (int ty = y0 / kHizTile; ty <= (y1 - 1) / kHizTile; ++ty) {
+            const bool full_y = ty * kHizTile >= y0 && std::min((ty + 1) * kHizTile, height_) <= y1;
+            for (int tx = x0 / kHizTile; tx <= (x1 - 1) / kHizTile; ++tx) {
+                const bool full =
+                    full_y && tx * kHizTile >= x0 && std::min((tx + 1) * kHizTile, width_) <= x1;
+                float& m = hiz_[ty * hiz_w_ + tx];
+                m = full ? v : std::max(m, v);
+            }
+        }
+    }
+
+    // Decoded NDC z (the stored value, so quantized for unorm formats).
+    float get(int x, int y) const {
+        const size_t i = size_t(y) * size_t(width_) + size_t(x);
+        switch (format_) {
+        case DepthFormat::D24S8:
+            return from_unorm(d24s8_[i] >> 8, kMax24);
+        case DepthFormat::D16:
+            return from_unorm(d16_[i], kMax16);
+        case DepthFormat::F32:
+        default:
+            return z_[i];
+        }
+    }
+    void set(int x, int y, float v) {
+        const size_t i = size_t(y) * size_t(width_) + size_t(x);
+        switch (format_) {
+        case DepthFormat::F32:
+            z_[i] = v;
+            break;
+        case DepthFormat::D24S8:
+            d24s8_[i] = (to_unorm(v, kMax24) << 8) | (d24s8_[i] & 0xFFu);
+            break;
+        case DepthFormat::D16:
+            d16_[i] = uint16_t(to_unorm(v, kMax16));
+            break;
+        }
+        // Raising the tile max keeps it conservative; lowering waits for refresh_tile_max().
+        float& m = hiz_[(y / kHizTile) * hiz_w_ + x / kHizTile];
+        const float stored = get(x, y);
+        if (stored > m)
+            m = stored;
+    }
+
+    // Raw storage, width() values per row, in format() layout (the others return null).
+    float* data() { return format_ == DepthFormat::F32 ? z_.data() : nullptr; }
+    const float* data() const { return format_ == DepthFormat::F32 ? z_.data() : nullptr; }
+    void* raw() {
+        switch (format_) {
+        case DepthFormat::D24S8:
+            return d24s8_.data();
+        case DepthFormat::D16:
+            return d16_.data();
+        case DepthFormat::F32:
+        default:
+            return z_.data();
+        }
     }
 
-    float get(int x, int y) const { return z_[y * width_ + x]; }
-    void set(int x, int y, float v) { z_[y * width_ + x] = v; }
+    int hiz_width() const { return hiz_w_; }
+    int hiz_height() const { return hiz_h_; }
+    float tile_max(int tx, int ty) const { return hiz_[ty * hiz_w_ + tx]; }
+    float* hiz_data() { return hiz_.data(); }
+    const float* hiz_data() const { return hiz_.data(); }
+
+    // Recomputes one tile's max from its pixels (after depth writes that may have lowered it).
+    void refresh_tile_max(int tx, int ty) {
+        const int x0 = tx * kHizTile;
+        const int y0 = ty * kHizTile;
+        const int x1 = std::min(x0 + kHizTile, width_);
+        const int y1 = std::min(y0 + kHizTile, height_);
+        float m = -std::numeric_limits<float>::infinity();
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x)
+                m = std::max(m, get(x, y));
+        }
+        hiz_[ty * hiz_w_ + tx] = m;
+    }
 
   private:
     int width_ = 0;
     int height_ = 0;
-    std::vector<float> z_;
+    int max_w_ = 0;
+    int max_h_ = 0;
+    DepthFormat format_ = DepthFormat::F32;
+    std::vector<float> z_;        // F32
+    std::vector<uint32_t> d24s8_; // D24S8
+    std::vector<uint16_t> d16_;   // D16
+    int hiz_w_ = 0;
+    int hiz_h_ = 0;
+    std::vector<float> hiz_;
 };
 
 } // namespace sr::gfx
@@ -19,6 +19,7 @@ struct Font5x7 {
         {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
         {':', {0x00, 0x04, 0x00, 0x00, 0x04, 0x00, 0x00}},
         {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06}},
+        {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
         {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
         {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
         {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
@@ -29,9 +30,27 @@ struct Font5x7 {
         {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
         {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
         {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+        {'A', {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+        {'C', {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}},
+        {'D', {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}},
+        {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
         {'F', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}},
+        {'G', {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}},
+        {'H', {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+        {'I', {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+        {'K', {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}},
+        {'L', {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}},
+        {'M', {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}},
+        {'N', {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}},
+        {'O', {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
         {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+        {'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
         {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+        {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+        {'U', {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+        {'V', {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}},
+        {'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+        {'Y', {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}},
     };
 
     static constexpr const Glyph* find(char c) {
@@ -52,7 +71,6 @@ inline void draw_char_5x7(Framebuffer& fb, int x, int y, char c, uint32_t argb,
 
     const int w = fb.width();
     const int h = fb.height();
-    uint32_t* pix = fb.pixels();
 
     for (int row = 0; row < 7; ++row) {
         uint8_t bits = g->rows[row];
@@ -66,8 +84,9 @@ inline void draw_char_5x7(Framebuffer& fb, int x, int y, char c, uint32_t argb,
             const int px1 = std::min(px0 + scale, w);
             const int py1 = std::min(py0 + scale, h);
             for (int py = std::max(py0, 0); py < py1; ++py) {
+                uint32_t* pix = fb.row(py);
                 for (int px = std::max(px0, 0); px < px1; ++px) {
-                    pix[py * w + px] = argb;
+                    pix[px] = argb;
                 }
             }
         }
@@ -1,26 +1,53 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace sr::gfx {
 
-// CPU pixel buffer: ARGB8888.
+// CPU pixel buffer: ARGB8888, rows stride() pixels apart. Owns its pixels unless wrap() points it
+// at external memory (e.g. a locked streaming texture), so the renderer can draw straight into
+// the presentation surface.
 class Framebuffer {
   public:
     Framebuffer(int w, int h);
 
     int width() const { return width_; }
     int height() const { return height_; }
+    int stride() const { return stride_; }
+    int max_width() const { return max_w_; }
+    int max_height() const { return max_h_; }
+
+    // Shrinks or regrows the used area to the top-left w x h of the size it was built with,
+    // keeping the stride and storage (no reallocation; pixels are left as they are). Fails when
+    // w x h does not fit.
+    bool resize(int w, int h);
+
+    // Uses `pixels` (max_width() x max_height(), `pitch_bytes` apart) until unwrap(); the caller
+    // keeps ownership. Fails, keeping the current storage, when the pitch is not a whole number of
+    // pixels or is shorter than a full-size row.
+    bool wrap(void* pixels, int pitch_bytes);
+    // Back to the owned buffer (its contents are whatever was last drawn into it).
+    void unwrap();
+    bool wrapped() const { return external_ != nullptr; }
 
     void clear(uint32_t argb);
-    uint32_t* pixels() { return pixels_.data(); }
-    const uint32_t* pixels() const { return pixels_.data(); }
+    // Fills [x0, x1) x [y0, y1), clamped to the buffer.
+    void clear_rect(int x0, int y0, int x1, int y1, uint32_t argb);
+    uint32_t* pixels() { return external_ ? external_ : pixels_.data(); }
+    const uint32_t* pixels() const { return external_ ? external_ : pixels_.data(); }
+    uint32_t* row(int y) { return pixels() + size_t(y) * size_t(stride_); }
+    const uint32_t* row(int y) const { return pixels() + size_t(y) * size_t(stride_); }
 
   private:
     int width_ = 0;
     int height_ = 0;
+    int stride_ = 0;
+    int max_w_ = 0;
+    int max_h_ = 0;
     std::vector<uint32_t> pixels_;
+    uint32_t* external_ = nullptr;
 };
 
 } // namespace sr::gfx
@@ -1,24 +1,46 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace sr::gfx {
 
-// Immutable ARGB8888 texture in CPU memory (matches framebuffer format).
+// Texel order in memory. Tiled stores 4x4 blocks (64 bytes, one cache line) row-major, each
+// block row-major inside, so samples walking in v stay within a line for 4 rows instead of
+// touching a new one per row.
+enum class TexelLayout : uint8_t { Linear, Tiled };
+
+// Immutable ARGB8888 texture in CPU memory (matches framebuffer format), with an optional
+// box-filtered mip chain stored after level 0 in the same buffer.
 class Texture {
   public:
+    struct Level {
+        int width = 0;
+        int height = 0;
+        size_t offset = 0; // first texel in pixels()
+        int tiles_x = 0;   // 4x4 blocks per block row (Tiled only)
+    };
+
     Texture() = default;
     Texture(int w, int h, std::vector<uint32_t> argb, bool has_alpha, uint8_t alpha_min,
             uint8_t alpha_max, float alpha_non_opaque_frac)
         : width_(w), height_(h), pixels_(std::move(argb)), has_alpha_(has_alpha),
           alpha_min_(alpha_min), alpha_max_(alpha_max),
-          alpha_non_opaque_frac_(alpha_non_opaque_frac) {}
+          alpha_non_opaque_frac_(alpha_non_opaque_frac), levels_{Level{w, h, 0, 0}} {}
 
     int width() const { return width_; }
     int height() const { return height_; }
+    // Raw storage, all levels, in layout() order; use texel() for coordinate access.
     const uint32_t* pixels() const { return pixels_.data(); }
     bool has_alpha() const { return has_alpha_; }
+    // Both sides powers of two (then every mip level is too), see sample_repeat_pow2().
+    bool pow2() const {
+        return width_ > 0 && height_ > 0 && std::has_single_bit(unsigned(width_)) &&
+               std::has_single_bit(unsigned(height_));
+    }
     uint8_t alpha_min() const { return alpha_min_; }
     uint8_t alpha_max() const { return alpha_max_; }
     float alpha_non_opaque_frac() const { return alpha_non_opaque_frac_; }
@@ -31,9 +53,73 @@ class Texture {
         return (alpha_min_ == 0) && (alpha_max_ == 255);
     }
 
+    // Builds levels 1..n down to 1x1. Cutout textures get per-level alpha scaling so the share
+    // of texels passing a 0.5 cutoff matches level 0 (plain averaging makes foliage and fences
+    // thin out and vanish with distance).
+    void build_mips();
+    int level_count() const { return int(levels_.size()); }
+    const Level& level(int i) const { return levels_[size_t(i)]; }
+
+    // Reorders every level in place. Tiled levels are padded to whole 4x4 blocks (edge texels
+    // repeated); sampling results are identical in either layout.
+    void set_layout(TexelLayout layout);
+    TexelLayout layout() const { return layout_; }
+
+    // Texel (x, y) of `level`, no wrapping; coordinates must be in range.
+    uint32_t texel(int x, int y, int level = 0) const {
+        return pixels_[texel_index(levels_[size_t(level)], x, y)];
+    }
+
+    // Nearest texel of level 0 / of `level` (clamped to the chain), repeat addressing (see
+    // repeat_texel()).
     uint32_t sample_repeat(float u, float v) const;
+    uint32_t sample_repeat(float u, float v, int level) const;
+
+    // sample_repeat() for pow2() textures, without the call or the level clamp: both map a
+    // coordinate with repeat_texel(), here with the multiply by size - 1 done as a shift and a
+    // subtract, so they return the same texel for every UV. `level` must exist.
+    uint32_t sample_repeat_pow2(float u, float v, int level) const {
+        const Level& lv = levels_[size_t(level)];
+        const int sx = std::countr_zero(unsigned(lv.width));
+        const int sy = std::countr_zero(unsigned(lv.height));
+        const uint64_t fu = repeat_fixed(u);
+        const uint64_t fv = repeat_fixed(v);
+        const int x = int(((fu << sx) - fu) >> 32); // fu * (width - 1) >> 32
+        const int y = int(((fv << sy) - fv) >> 32);
+        if (layout_ == TexelLayout::Tiled)
+            return pixels_[texel_index(lv, x, y)];
+        return pixels_[lv.offset + (size_t(y) << sx) + size_t(x)];
+    }
+
+    // Bilinear, repeat addressing. Texel centres sit at (i + 0.5) / size (not the nearest
+    // samplers' size - 1 scaling) so the filter wraps across the seam. Coordinates are 24.8
+    // fixed point and the four texels are blended per 8-bit channel with 8-bit weights:
+    // lerp(a, b, w) = (a * (256 - w) + b * w) >> 8, across x first, then y. The SIMD raster
+    // kernels filter a lane group with the same integer math, so results match exactly.
+    uint32_t sample_bilinear(float u, float v, int level) const;
 
   private:
+    // Fractional part of `t` in 0.32 fixed point. Floats of magnitude 2^23 and up are integers,
+    // so clamping to +-2^30 (to keep the conversion in range) does not change the result.
+    static uint64_t repeat_fixed(float t) {
+        t = std::clamp(t, -1073741824.0f, 1073741824.0f);
+        return uint64_t(uint32_t(uint64_t(int64_t(t * 4294967296.0f))));
+    }
+
+    // Nearest texel of `size` for coordinate `t`, repeat addressing: frac(t) * (size - 1),
+    // truncated, in exact integer math (0 .. size - 2, or 0 when size is 1).
+    static int repeat_texel(float t, int size) {
+        return int((repeat_fixed(t) * uint64_t(size - 1)) >> 32);
+    }
+
+    size_t texel_index(const Level& lv, int x, int y) const {
+        if (layout_ == TexelLayout::Tiled) {
+            return lv.offset + (size_t(y >> 2) * size_t(lv.tiles_x) + size_t(x >> 2)) * 16u +
+                   size_t(((y & 3) << 2) | (x & 3));
+        }
+        return lv.offset + size_t(y) * size_t(lv.width) + size_t(x);
+    }
+
     int width_ = 0;
     int height_ = 0;
     std::vector<uint32_t> pixels_; // ARGB8888 (SDL_PIXELFORMAT_ARGB8888)
@@ -41,6 +127,8 @@ class Texture {
     uint8_t alpha_min_ = 255;
     uint8_t alpha_max_ = 255;
     float alpha_non_opaque_frac_ = 0.0f;
+    std::vector<Level> levels_;
+    TexelLayout layout_ = TexelLayout::Linear;
 };
 
 } // namespace sr::gfx
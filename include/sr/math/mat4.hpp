@@ -4,9 +4,21 @@
 #include "sr/math/vec4.hpp"
 
 #include <cmath>
+#include <cstdint>
 
 namespace sr::math {
 
+// Where perspective() puts view depth in NDC z. Both keep "smaller is closer" with near at -1, so
+// the depth test, the +inf clear and the HiZ max tiles work unchanged.
+enum class DepthMapping : uint8_t {
+    // OpenGL: far at +1. Distant geometry lands just below 1, where floats are coarsest (steps of
+    // 2^-24 there are ~0.5 world units at 3000 for near = 0.1), so far layers z-fight.
+    Standard = 0,
+    // Reverse-Z (negated): far at 0, z ~= -near / w away from the camera, so floats get denser
+    // with distance. Clip volume is -w <= z <= 0 instead of -w <= z <= w.
+    ReverseZ = 1,
+};
+
 // Row-major 4x4 matrix; vectors treated as column vectors:
 //   v' = M * v
 struct Mat4 {
@@ -70,14 +82,21 @@ struct Mat4 {
         return r;
     }
 
-    // OpenGL-style right-handed perspective projection (NDC z in [-1,1]).
-    static Mat4 perspective(float fov_y_rad, float aspect, float z_near, float z_far) {
+    // OpenGL-style right-handed perspective projection (NDC z in [-1,1], or [-1,0] for
+    // DepthMapping::ReverseZ).
+    static Mat4 perspective(float fov_y_rad, float aspect, float z_near, float z_far,
+                            DepthMapping mapping = DepthMapping::Standard) {
         Mat4 r{};
         float f = 1.0f / std::tan(fov_y_rad * 0.5f);
         r.m[0][0] = f / aspect;
         r.m[1][1] = f;
-        r.m[2][2] = (z_far + z_near) / (z_near - z_far);
-        r.m[2][3] = (2.0f * z_far * z_near) / (z_near - z_far);
+        if (mapping == DepthMapping::ReverseZ) {
+            r.m[2][2] = z_near / (z_near - z_far);
+            r.m[2][3] = (z_far * z_near) / (z_near - z_far);
+        } else {
+            r.m[2][2] = (z_far + z_near) / (z_near - z_far);
+            r.m[2][3] = (2.0f * z_far * z_near) / (z_near - z_far);
+        }
         r.m[3][2] = -1.0f;
         return r;
     }
@@ -138,4 +157,45 @@ inline Vec4 mul(const Mat4& a, const Vec4& v) {
     };
 }
 
+// General inverse (cofactors over 2x2 sub-determinants). Singular matrices give identity.
+inline Mat4 inverse(const Mat4& a) {
+    const auto& m = a.m;
+    const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+    const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+    const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+    const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f)
+        return Mat4::identity();
+    const float inv = 1.0f / det;
+
+    Mat4 r;
+    r.m[0][0] = (m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * inv;
+    r.m[0][1] = (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * inv;
+    r.m[0][2] = (m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * inv;
+    r.m[0][3] = (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * inv;
+    r.m[1][0] = (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * inv;
+    r.m[1][1] = (m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * inv;
+    r.m[1][2] = (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * inv;
+    r.m[1][3] = (m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * inv;
+    r.m[2][0] = (m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * inv;
+    r.m[2][1] = (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * inv;
+    r.m[2][2] = (m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * inv;
+    r.m[2][3] = (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * inv;
+    r.m[3][0] = (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * inv;
+    r.m[3][1] = (m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * inv;
+    r.m[3][2] = (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * inv;
+    r.m[3][3] = (m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * inv;
+    return r;
+}
+
 } // namespace sr::math
@@ -30,4 +30,13 @@ inline float max_scale_component(const Mat4& m) {
     return std::max({sx, sy, sz});
 }
 
+// True when the 3x3 part has a negative determinant: the transform mirrors, swapping winding.
+inline bool mirrors(const Mat4& m) {
+    const auto& a = m.m;
+    const float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+                      a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                      a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    return det < 0.0f;
+}
+
 } // namespace sr::math
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sr::platform {
+
+// Fixed set of worker threads for data-parallel loops (tile raster, etc.).
+// The calling thread joins in, so a pool built with N lanes runs N ways wide using N-1 threads.
+class WorkerPool {
+  public:
+    // lanes <= 0 picks std::thread::hardware_concurrency().
+    explicit WorkerPool(int lanes = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int lanes() const { return int(threads_.size()) + 1; }
+
+    // Runs fn(i) for i in [0, count), handing out indices dynamically. Blocks until all are done.
+    void parallel_for(int count, const std::function<void(int)>& fn);
+
+  private:
+    void worker_main();
+    void run_items();
+
+    std::vector<std::thread> threads_;
+
+    std::mutex mu_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* job_ = nullptr;
+    int job_count_ = 0;
+    std::atomic<int> next_{0};
+    int busy_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace sr::platform
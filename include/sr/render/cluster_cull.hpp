@@ -0,0 +1,76 @@
+#pragma once
+
+#include "sr/assets/model.hpp"
+#include "sr/math/mat4.hpp"
+#include "sr/math/transform.hpp"
+#include "sr/math/vec3.hpp"
+#include "sr/render/frustum.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sr::render {
+
+// One placement of a clustered model (see sr::assets::build_clusters()) as the camera sees it.
+// Cluster bounds and normal cones are in model space, so the eye is taken there once.
+struct ClusterView {
+    const Frustum* frustum = nullptr;
+    const sr::math::Mat4* transform = nullptr; // model to world
+    float scale = 1.0f;                        // max_scale_component(*transform)
+    sr::math::Vec3 eye{0.0f, 0.0f, 0.0f};      // camera position, model space
+    bool mirrored = false;                     // transform flips the front-facing winding
+};
+
+// `frustum` and `transform` must outlive the view; `eye` is in world space.
+inline ClusterView cluster_view(const Frustum& frustum, const sr::math::Mat4& transform,
+                                const sr::math::Vec3& eye) {
+    ClusterView v;
+    v.frustum = &frustum;
+    v.transform = &transform;
+    v.scale = sr::math::max_scale_component(transform);
+    v.eye = sr::math::transform_point(sr::math::inverse(transform), eye);
+    v.mirrored = sr::math::mirrors(transform);
+    return v;
+}
+
+// Inside the frustum and, unless `double_sided`, not entirely facing away (`front_ccw` is the
+// material's front winding, before mirroring).
+inline bool cluster_visible(const ClusterView& view, const sr::assets::Cluster& cl,
+                            bool double_sided, bool front_ccw) {
+    const sr::math::Vec3 c = sr::math::transform_point(*view.transform, cl.bounds_center);
+    return view.frustum->sphere_visible(c, cl.bounds_radius * view.scale) &&
+           (double_sided || !cl.backfacing(view.eye, front_ccw != view.mirrored));
+}
+
+// Culls `prim`'s clusters in order. For each survivor, vertices(list, count) gets the vertices
+// its triangles use (Model::cluster_vertices); for each run of consecutive survivors,
+// run(begin, end) gets its index range, clamped to the draw's [begin, end). Callers transform
+// the vertices and draw the runs.
+template <typename VertexFn, typename RunFn>
+void for_each_visible_run(const ClusterView& view, const sr::assets::Model& model,
+                          const sr::assets::Primitive& prim, bool double_sided, bool front_ccw,
+                          uint32_t begin, uint32_t end, VertexFn&& vertices, RunFn&& run) {
+    uint32_t run_begin = 0;
+    uint32_t run_end = 0;
+    auto flush_run = [&] {
+        const uint32_t b = std::max(run_begin, begin);
+        const uint32_t e = std::min(run_end, end);
+        if (b < e)
+            run(b, e);
+        run_begin = run_end = 0;
+    };
+    for (uint32_t c = 0; c < prim.cluster_count; ++c) {
+        const sr::assets::Cluster& cl = model.clusters[prim.cluster_offset + c];
+        if (!cluster_visible(view, cl, double_sided, front_ccw)) {
+            flush_run();
+            continue;
+        }
+        vertices(model.cluster_vertices.data() + cl.vertex_offset, cl.vertex_count);
+        if (run_begin == run_end)
+            run_begin = cl.index_offset;
+        run_end = cl.index_offset + cl.index_count;
+    }
+    flush_run();
+}
+
+} // namespace sr::render
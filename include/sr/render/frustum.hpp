@@ -18,10 +18,13 @@ struct Frustum {
     // Order: left, right, bottom, top, near, far.
     std::array<Plane, 6> planes{};
 
-    static Frustum from_view_proj(const sr::math::Mat4& vp) {
+    // `mapping` must match the projection in `vp` (it moves the far plane, see DepthMapping).
+    static Frustum
+    from_view_proj(const sr::math::Mat4& vp,
+                   sr::math::DepthMapping mapping = sr::math::DepthMapping::Standard) {
         // With column vectors and row-major storage:
         // clip = VP * world_h
-        // Inside is: -w<=x<=w, -w<=y<=w, -w<=z<=w.
+        // Inside is: -w<=x<=w, -w<=y<=w, -w<=z<=w (-w<=z<=0 for ReverseZ).
         auto row = [&](int r) {
             return std::array<float, 4>{vp.m[r][0], vp.m[r][1], vp.m[r][2], vp.m[r][3]};
         };
@@ -54,7 +57,10 @@ struct Frustum {
         f.planes[2] = make(add(r3, r1)); // bottom: y + w >= 0
         f.planes[3] = make(sub(r3, r1)); // top:   -y + w >= 0
         f.planes[4] = make(add(r3, r2)); // near:  z + w >= 0
-        f.planes[5] = make(sub(r3, r2)); // far:   -z + w >= 0
+        if (mapping == sr::math::DepthMapping::ReverseZ)
+            f.planes[5] = make({-r2[0], -r2[1], -r2[2], -r2[3]}); // far: -z >= 0
+        else
+            f.planes[5] = make(sub(r3, r2)); // far:   -z + w >= 0
         return f;
     }
 
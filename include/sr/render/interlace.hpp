@@ -0,0 +1,32 @@
+#pragma once
+
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/gfx/framebuffer.hpp"
+#include "sr/math/mat4.hpp"
+#include "sr/platform/worker_pool.hpp"
+
+namespace sr::render {
+
+// Inputs for rebuilding a full frame from one interlaced field (Renderer::set_field()).
+struct FieldReconstruction {
+    const sr::gfx::Framebuffer* field = nullptr; // the rendered field, (frame height + 1) / 2 rows
+    const sr::gfx::DepthBuffer* field_depth = nullptr;
+    int parity = 0;                // frame rows the field holds: 2k + parity
+    sr::math::Mat4 view_proj;      // this frame (frame aspect, see view_proj())
+    sr::math::Mat4 prev_view_proj; // the frame in `history`
+    float far_z = 1.0f;            // NDC z of the far plane; cleared depth is clamped to it
+    // Previous reconstructed frame, without overlays. Null, or a different size than the output,
+    // fills the missing rows by interpolation only.
+    const sr::gfx::Framebuffer* history = nullptr;
+};
+
+// Writes the frame into `out` (set_field()'s frame size): field rows are copied, and each missing
+// pixel takes the history pixel its surface came from. Its depth is the nearer of the field pixels
+// above and below; the pixel is unprojected with this frame's matrices and projected with the
+// previous ones. The history color is clamped to the range of those 6 field neighbours (x-1..x+1
+// above and below), which cuts ghosting on disocclusions; off-screen history falls back to the
+// average of the pixels above and below. Row bands run on `pool` when given.
+void reconstruct_field(const FieldReconstruction& in, sr::gfx::Framebuffer& out,
+                       sr::platform::WorkerPool* pool = nullptr);
+
+} // namespace sr::render
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/math/mat4.hpp"
+#include "sr/math/vec3.hpp"
+#include "sr/render/renderer.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace sr::render {
+
+// Max-depth pyramid over frame pixels: level 0 holds one NDC z per cell (nothing nearer than it
+// is hidden there; +inf = no occluder), each next level the max of 2x2 cells.
+struct DepthPyramid {
+    int frame_w = 0;
+    int frame_h = 0;
+    int cell_w = 8; // frame pixels per level-0 cell
+    int cell_h = 8;
+    int y_offset = 0; // frame row where cell row 0 starts (a field's parity)
+    std::vector<int> level_w;
+    std::vector<int> level_h;
+    std::vector<size_t> level_offset;
+    std::vector<float> z;
+
+    // Lays out levels for a w x h level 0 (contents undefined until filled).
+    void reset(int w, int h);
+    float* level0() { return z.data(); }
+    // Fills levels 1.. from level 0.
+    void build();
+    // Conservative max over the cells covering frame pixels [x0, x1] x [y0, y1] (clamped).
+    float max_depth(int x0, int y0, int x1, int y1) const;
+};
+
+// Occlusion culling against the previous frame's depth, reprojected to this frame's camera.
+//
+// Per frame: begin() turns the depth captured last frame into a pyramid for this camera;
+// occluded() tests world-space boxes against it (before their meshes are transformed); after the
+// renderer's flush(), end() captures this frame's depth (its HiZ tile maxima, so no extra pass
+// over the pixels) for the next frame. Blended draws leave the HiZ alone (raster::kRefreshesHiz),
+// so only opaque and cutout surfaces occlude.
+//
+// Reprojection is not exact (moving occluders are stale by a frame, parallax at depth edges), so
+// end() first re-tests the boxes culled this frame against the frame's own depth. A box that
+// would have been visible there is drawn unconditionally next frame; once drawn, its own depth
+// keeps it visible. A wrong cull therefore shows for one frame at most.
+class OcclusionCuller {
+  public:
+    struct Stats {
+        uint32_t tested = 0;
+        uint32_t culled = 0;
+        uint32_t missed = 0; // culled but visible in the frame's own depth (drawn next frame)
+    };
+
+    // `view_proj` must be what `renderer` transforms with this frame (see view_proj()).
+    void begin(const Renderer& renderer, const sr::math::Mat4& view_proj, float far_z);
+
+    // True when the box [lo, hi] is behind the reprojected depth everywhere it covers. `id` names
+    // the bounds across frames for the one-frame fix-up (any stable key, e.g. entity and part).
+    bool occluded(uint64_t id, const sr::math::Vec3& lo, const sr::math::Vec3& hi);
+
+    // Call after the renderer's flush().
+    void end(const Renderer& renderer);
+
+    // Forgets the captured depth (e.g. while culling is off, so it is never stale).
+    void reset();
+
+    const Stats& stats() const { return stats_; }
+
+  private:
+    struct Culled {
+        uint64_t id = 0;
+        sr::math::Vec3 lo;
+        sr::math::Vec3 hi;
+    };
+
+    bool have_prev_ = false;
+    DepthPyramid prev_; // last frame's HiZ, in its own frame pixels
+    sr::math::Mat4 prev_view_proj_ = sr::math::Mat4::identity();
+    float prev_far_z_ = 1.0f;
+
+    bool active_ = false; // begin() had depth to reproject
+    DepthPyramid cur_;    // prev_ reprojected to this frame
+    sr::math::Mat4 view_proj_ = sr::math::Mat4::identity();
+    float far_z_ = 1.0f;
+
+    std::vector<Culled> culled_;
+    std::vector<uint64_t> force_;      // culled wrongly last frame; sorted
+    std::vector<uint64_t> next_force_; // being collected by end()
+    Stats stats_;
+};
+
+} // namespace sr::render
@@ -0,0 +1,389 @@
+#pragma once
+
+#include "sr/assets/material.hpp"
+#include "sr/gfx/depthbuffer.hpp"
+#include "sr/gfx/texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// SIMD kernels are built with per-function target attributes (no special compile flags) and
+// picked at runtime, so a generic x86-64 build still uses AVX2 where the CPU has it.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SR_RASTER_X86 1
+#else
+#define SR_RASTER_X86 0
+#endif
+
+namespace sr::render::raster {
+
+// Screen-space vertex after the perspective divide (pixel units, y down).
+struct Vertex {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f; // NDC z in [-1,1] (smaller is closer)
+    float u_over_w = 0.0f;
+    float v_over_w = 0.0f;
+    float inv_w = 0.0f;
+};
+
+// Inclusive pixel rectangle the raster loop is limited to (full screen or one tile).
+struct Rect {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+};
+
+struct Target {
+    uint32_t* color = nullptr;
+    uint32_t* ids = nullptr; // visibility buffer (Pass::Visibility only)
+    void* depth = nullptr;   // DepthBuffer::raw(), `depth_format` values
+    sr::gfx::DepthFormat depth_format = sr::gfx::DepthFormat::F32;
+    int width = 0;
+    int height = 0;
+    int color_stride = 0; // pixels between `color` rows; id and depth rows are `width` apart
+    float* hiz = nullptr;  // DepthBuffer tile maxima, hiz_width per row
+    int hiz_width = 0;
+    uint64_t* fragments = nullptr; // optional: += fragments that passed the depth test
+};
+
+struct State {
+    const sr::gfx::Texture* tex = nullptr;
+    sr::assets::AlphaMode alpha_mode = sr::assets::AlphaMode::Opaque;
+    uint8_t alpha_cut = 128; // Mask: fragments with alpha below this are discarded.
+    uint32_t vis_id = 0;     // Pass::Visibility: value written to the id buffer
+};
+
+// Forward shades and writes color; Visibility writes only depth and `State::vis_id`, leaving
+// texturing to a resolve pass (Opaque/Mask only: Mask still samples alpha to discard).
+enum class Pass : uint8_t {
+    Forward = 0,
+    Visibility = 1,
+};
+
+// Texture lookup, picked per draw from the material's filter and the bound texture (like the
+// alpha mode, it is a kernel template argument rather than a per-fragment branch).
+enum class Sampler : uint8_t {
+    Repeat = 0,     // nearest, repeat, any size
+    RepeatPow2 = 1, // power-of-two textures, same texels as Repeat without the multiply
+    Bilinear = 2,   // sample_bilinear; SIMD kernels filter a whole lane group at once
+};
+constexpr int kSamplerCount = 3;
+
+inline Sampler sampler_for(const sr::gfx::Texture& tex,
+                           sr::assets::TextureFilter filter = sr::assets::TextureFilter::Nearest) {
+    if (filter == sr::assets::TextureFilter::Linear)
+        return Sampler::Bilinear;
+    return tex.pow2() ? Sampler::RepeatPow2 : Sampler::Repeat;
+}
+
+template <Sampler S>
+inline uint32_t sample(const sr::gfx::Texture& tex, float u, float v, int lod) {
+    if constexpr (S == Sampler::RepeatPow2)
+        return tex.sample_repeat_pow2(u, v, lod);
+    else if constexpr (S == Sampler::Bilinear)
+        return tex.sample_bilinear(u, v, lod);
+    else
+        return tex.sample_repeat(u, v, lod);
+}
+
+// Depth storage per DepthBuffer format: T is the stored value, key() encodes a fragment's z
+// once for both the test (`key < stored_key(*p)` passes) and store(), the value it writes.
+template <sr::gfx::DepthFormat D> struct DepthOps;
+template <> struct DepthOps<sr::gfx::DepthFormat::F32> {
+    using T = float;
+    using Key = float;
+    static float key(float z) { return z; }
+    static float stored_key(float s) { return s; }
+    static float store(float k, float) { return k; }
+};
+template <> struct DepthOps<sr::gfx::DepthFormat::D24S8> {
+    using T = uint32_t;
+    using Key = uint32_t;
+    static constexpr uint32_t kMax = sr::gfx::DepthBuffer::kMax24;
+    static uint32_t key(float z) { return sr::gfx::DepthBuffer::to_unorm(z, kMax); }
+    static uint32_t stored_key(uint32_t s) { return s >> 8; }
+    static uint32_t store(uint32_t k, uint32_t old) { return (k << 8) | (old & 0xFFu); }
+};
+template <> struct DepthOps<sr::gfx::DepthFormat::D16> {
+    using T = uint16_t;
+    using Key = uint32_t;
+    static constexpr uint32_t kMax = sr::gfx::DepthBuffer::kMax16;
+    static uint32_t key(float z) { return sr::gfx::DepthBuffer::to_unorm(z, kMax); }
+    static uint32_t stored_key(uint16_t s) { return s; }
+    static uint16_t store(uint32_t k, uint16_t) { return uint16_t(k); }
+};
+
+template <sr::gfx::DepthFormat D> using DepthT = typename DepthOps<D>::T;
+template <sr::gfx::DepthFormat D> using DepthKey = typename DepthOps<D>::Key;
+
+// Whether a kernel needs perspective-correct UVs at all (an opaque visibility pass does not).
+template <sr::assets::AlphaMode M, Pass P>
+constexpr bool kNeedsUv = !(P == Pass::Visibility && M == sr::assets::AlphaMode::Opaque);
+
+// Sub-pixel precision of snapped vertex positions (24.8 fixed point).
+constexpr int kSubpixelBits = 8;
+constexpr int kSubpixelOne = 1 << kSubpixelBits;
+
+// attr(px, py) = base + ddx * (px - ox) + ddy * (py - oy), evaluated at pixel centres.
+struct Plane {
+    float base = 0.0f;
+    float ddx = 0.0f;
+    float ddy = 0.0f;
+};
+
+// Per-triangle constants.
+// Edges are integer functions of the snapped 24.8 vertices, sign-normalized and biased for the
+// top-left fill rule, so a pixel is covered exactly when all three values are >= 0 and a pixel
+// centre on an edge shared by two triangles is covered by exactly one of them.
+struct Setup {
+    int64_t e0[3]{};   // edge values at the centre of pixel (minx, miny)
+    int64_t e_dx[3]{}; // step per pixel in +x
+    int64_t e_dy[3]{}; // step per pixel in +y
+
+    // Plane origin (snapped vertex a, pixel units). Planes are anchored there rather than at the
+    // box corner so a pixel gets the same attributes no matter which tile rasterizes it.
+    float ox = 0.0f;
+    float oy = 0.0f;
+    Plane z;
+    Plane inv_w;
+    Plane u_over_w;
+    Plane v_over_w;
+    float zmin = 0.0f; // smallest vertex z (the plane's minimum over the triangle)
+    Rect box;          // pixel box before clipping to the raster rect (same for every tile)
+
+    int minx = 0;
+    int maxx = -1;
+    int miny = 0;
+    int maxy = -1;
+};
+
+// Returns false when the triangle is degenerate or misses `rect`.
+bool setup_triangle(const Vertex& a, const Vertex& b, const Vertex& c, const Rect& rect,
+                    Setup& out);
+
+uint8_t alpha_cut_from_cutoff(float alpha_cutoff);
+
+enum class Isa : uint8_t {
+    Scalar = 0,
+    Sse41 = 1,
+    Avx2 = 2,
+};
+
+// Best kernel this CPU can run (and this build compiled).
+Isa detect_isa();
+const char* isa_name(Isa isa);
+
+// All kernels produce bit-identical output; they differ only in how many pixels they test per step.
+// Each is compiled once per alpha mode, pass, sampler and depth format, so the per-fragment path
+// carries no mode branches; `st.alpha_mode`, `st.tex` and `t.depth_format` must match what the
+// kernel was picked for. There is no Blend visibility kernel (blended draws are always shaded
+// forward).
+using KernelFn = void (*)(const Setup& s, const State& st, const Target& t);
+// The depth format is a template argument too; `t.depth_format` must match it.
+KernelFn kernel_for(Isa isa, sr::assets::AlphaMode mode, Pass pass = Pass::Forward,
+                    Sampler sampler = Sampler::Repeat,
+                    sr::gfx::DepthFormat depth = sr::gfx::DepthFormat::F32);
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+void kernel_scalar(const Setup& s, const State& st, const Target& t);
+#if SR_RASTER_X86
+// The target attribute has to be on the template's first declaration for GCC to honour it.
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+__attribute__((target("sse4.1"))) void kernel_sse41(const Setup& s, const State& st,
+                                                    const Target& t);
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+__attribute__((target("avx2"))) void kernel_avx2(const Setup& s, const State& st, const Target& t);
+#endif
+
+// Kernels walk the box in blocks aligned to the DepthBuffer HiZ tiles. Screen tiles used for
+// binning are multiples of this, so a block never straddles two workers.
+constexpr int kBlockSize = sr::gfx::DepthBuffer::kHizTile;
+
+// Part of the triangle box inside one HiZ tile, with edge values at its top-left pixel centre.
+struct Block {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+    int64_t e[3]{};
+};
+
+// Slack on the HiZ compare so plane-evaluation rounding can never reject a visible pixel.
+constexpr float kHizEpsilon = 1e-5f;
+
+// Sets up block (bx, by); returns false when no pixel in it can be drawn: entirely outside one
+// edge, or every fragment is behind the tile's max depth. Either way, no per-pixel work.
+inline bool enter_block(const Setup& s, const Target& t, int bx, int by, Block& b) {
+    b.x0 = std::max(s.minx, bx * kBlockSize);
+    b.y0 = std::max(s.miny, by * kBlockSize);
+    b.x1 = std::min(s.maxx, bx * kBlockSize + kBlockSize - 1);
+    b.y1 = std::min(s.maxy, by * kBlockSize + kBlockSize - 1);
+    const int64_t dx = b.x1 - b.x0;
+    const int64_t dy = b.y1 - b.y0;
+    for (int i = 0; i < 3; ++i) {
+        b.e[i] = s.e0[i] + int64_t(b.x0 - s.minx) * s.e_dx[i] + int64_t(b.y0 - s.miny) * s.e_dy[i];
+        // Edge functions are linear, so their max over the block is at one of its corners.
+        const int64_t emax =
+            b.e[i] + std::max<int64_t>(0, s.e_dx[i] * dx) + std::max<int64_t>(0, s.e_dy[i] * dy);
+        if (emax < 0)
+            return false;
+    }
+
+    if (!t.hiz)
+        return true;
+    // Lower bound of z over the block: the plane at its best corner, and never below the
+    // triangle's own minimum.
+    const float fx0 = (float(b.x0) + 0.5f) - s.ox;
+    const float fx1 = (float(b.x1) + 0.5f) - s.ox;
+    const float fy0 = (float(b.y0) + 0.5f) - s.oy;
+    const float fy1 = (float(b.y1) + 0.5f) - s.oy;
+    const float zlo = s.z.base + std::min(s.z.ddx * fx0, s.z.ddx * fx1) +
+                      std::min(s.z.ddy * fy0, s.z.ddy * fy1);
+    const float zmin = std::max(zlo, s.zmin) - kHizEpsilon;
+    return zmin < t.hiz[by * t.hiz_width + bx];
+}
+
+// Recomputes a HiZ tile after the kernel wrote depth into it.
+void refresh_hiz_block(const Target& t, int bx, int by);
+
+// Blended fragments still write depth but leave the HiZ tile as it was. Its max only becomes
+// more conservative, and the HiZ keeps describing opaque/cutout surfaces, which is what
+// OcclusionCuller takes as next frame's occluders: glass or foliage cards must not hide what is
+// behind them. (A later opaque write to the tile refreshes from the depth buffer, blended depth
+// included, so blended draws go last; RenderQueue orders them so.)
+template <sr::assets::AlphaMode M>
+constexpr bool kRefreshesHiz = M != sr::assets::AlphaMode::Blend;
+
+// Mip level for HiZ block (bx, by): nearest level for the texel footprint at the block centre
+// (clamped into the triangle's box), from the analytic derivatives of u = (u/w)/(1/w).
+// Depends only on the triangle and the block, so every tile, kernel and the visibility resolve
+// agree on it.
+inline int block_lod(const sr::gfx::Texture& tex, const Plane& inv_w, const Plane& u_over_w,
+                     const Plane& v_over_w, float ox, float oy, const Rect& box, int bx, int by) {
+    const int levels = tex.level_count();
+    if (levels <= 1)
+        return 0;
+    const float px = std::clamp(float(bx * kBlockSize) + 0.5f * float(kBlockSize), float(box.x0),
+                                float(box.x1) + 1.0f);
+    const float py = std::clamp(float(by * kBlockSize) + 0.5f * float(kBlockSize), float(box.y0),
+                                float(box.y1) + 1.0f);
+    const float dx = px - ox;
+    const float dy = py - oy;
+    const float iw = inv_w.base + inv_w.ddx * dx + inv_w.ddy * dy;
+    if (!(iw > 0.0f))
+        return 0;
+    const float rcp = 1.0f / iw;
+    const float u = (u_over_w.base + u_over_w.ddx * dx + u_over_w.ddy * dy) * rcp;
+    const float v = (v_over_w.base + v_over_w.ddx * dx + v_over_w.ddy * dy) * rcp;
+    const float tw = float(tex.width());
+    const float th = float(tex.height());
+    const float dudx = (u_over_w.ddx - u * inv_w.ddx) * rcp * tw;
+    const float dvdx = (v_over_w.ddx - v * inv_w.ddx) * rcp * th;
+    const float dudy = (u_over_w.ddy - u * inv_w.ddy) * rcp * tw;
+    const float dvdy = (v_over_w.ddy - v * inv_w.ddy) * rcp * th;
+    const float rho2 = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+    // round(log2(rho)) = floor(log2(2 * rho^2) / 2).
+    if (!(rho2 >= 0.5f))
+        return 0;
+    if (!(rho2 < 1e30f))
+        return levels - 1;
+    return std::min(levels - 1, std::ilogb(2.0f * rho2) >> 1);
+}
+
+inline int block_lod(const Setup& s, const State& st, int bx, int by) {
+    return block_lod(*st.tex, s.inv_w, s.u_over_w, s.v_over_w, s.ox, s.oy, s.box, bx, by);
+}
+
+struct RowAttrs {
+    float z;
+    float inv_w;
+    float u;
+    float v;
+};
+
+inline RowAttrs row_attrs(const Setup& s, int y) {
+    const float dy = (float(y) + 0.5f) - s.oy;
+    return RowAttrs{
+        s.z.base + s.z.ddy * dy,
+        s.inv_w.base + s.inv_w.ddy * dy,
+        s.u_over_w.base + s.u_over_w.ddy * dy,
+        s.v_over_w.base + s.v_over_w.ddy * dy,
+    };
+}
+
+// Color (or id) row the kernel writes for pass P.
+template <Pass P> inline uint32_t* out_row(const Target& t, int y) {
+    if constexpr (P == Pass::Visibility)
+        return t.ids + size_t(y) * size_t(t.width);
+    else
+        return t.color + size_t(y) * size_t(t.color_stride);
+}
+
+template <sr::gfx::DepthFormat D> inline DepthT<D>* depth_row(const Target& t, int y) {
+    return static_cast<DepthT<D>*>(t.depth) + size_t(y) * size_t(t.width);
+}
+
+template <sr::gfx::DepthFormat D> inline bool depth_passes(DepthKey<D> key, DepthT<D> stored) {
+    return key < DepthOps<D>::stored_key(stored);
+}
+
+// Alpha handling + write for one fragment that already passed coverage/depth, given its texel.
+// `color` points into the id buffer for Pass::Visibility.
+template <sr::assets::AlphaMode M, Pass P, sr::gfx::DepthFormat D>
+inline void shade_texel(uint32_t* color, DepthT<D>* depth, DepthKey<D> key, uint32_t src,
+                        const State& st) {
+    static_assert(P == Pass::Forward || M != sr::assets::AlphaMode::Blend,
+                  "blended draws have no visibility pass");
+    if constexpr (P == Pass::Visibility) {
+        if constexpr (M == sr::assets::AlphaMode::Mask) {
+            if (uint8_t(src >> 24) < st.alpha_cut)
+                return;
+        }
+        *color = st.vis_id;
+        *depth = DepthOps<D>::store(key, *depth);
+        return;
+    }
+
+    if constexpr (M == sr::assets::AlphaMode::Opaque) {
+        *color = src | 0xFF000000u;
+        *depth = DepthOps<D>::store(key, *depth);
+    } else if constexpr (M == sr::assets::AlphaMode::Mask) {
+        if (uint8_t(src >> 24) < st.alpha_cut)
+            return;
+        *color = src | 0xFF000000u;
+        *depth = DepthOps<D>::store(key, *depth);
+    } else {
+        // Blend (naive): depth-test as usual, then alpha-blend over the existing pixel.
+        const uint8_t a8 = uint8_t((src >> 24) & 0xFF);
+        if (a8 == 0)
+            return;
+        const uint32_t dst = *color;
+        const uint32_t inva = 255u - uint32_t(a8);
+        const uint32_t sr = (src >> 16) & 0xFFu;
+        const uint32_t sg = (src >> 8) & 0xFFu;
+        const uint32_t sb = (src)&0xFFu;
+        const uint32_t dr = (dst >> 16) & 0xFFu;
+        const uint32_t dg = (dst >> 8) & 0xFFu;
+        const uint32_t db = (dst)&0xFFu;
+        const uint32_t or_ = (sr * uint32_t(a8) + dr * inva) / 255u;
+        const uint32_t og_ = (sg * uint32_t(a8) + dg * inva) / 255u;
+        const uint32_t ob_ = (sb * uint32_t(a8) + db * inva) / 255u;
+        *color = 0xFF000000u | (or_ << 16) | (og_ << 8) | ob_;
+        *depth = DepthOps<D>::store(key, *depth);
+    }
+}
+
+// Texture fetch + shade_texel(). An opaque visibility pass never samples.
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+inline void shade_fragment(uint32_t* color, DepthT<D>* depth, DepthKey<D> key, float u, float v,
+                           int lod, const State& st) {
+    if constexpr (kNeedsUv<M, P>)
+        shade_texel<M, P, D>(color, depth, key, sample<S>(*st.tex, u, v, lod), st);
+    else
+        shade_texel<M, P, D>(color, depth, key, 0u, st);
+}
+
+} // namespace sr::render::raster
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "sr/assets/material.hpp"
+#include "sr/assets/mesh.hpp"
+#include "sr/gfx/texture.hpp"
+#include "sr/math/mat4.hpp"
+#include "sr/math/vec3.hpp"
+#include "sr/render/renderer.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace sr::render {
+
+// Per-frame command list of draws, executed in the order of a 64-bit sort key (high bits first):
+//
+//   [63:62] layer (Item::layer); layers run in order, e.g. world before overlays
+//   [61]    blended; opaque/cutout draws run before blended ones
+//   opaque: [60:45] view depth of the nearest point, coarse (the top 16 bits of the float, so
+//           steps of under 1%): front to back for early depth rejection
+//           [44:43] alpha mode, [42] filter, [41:26] texture: within a depth step, draws that
+//           share a texture and raster kernel (alpha mode and sampler) run back to back
+//   blend:  [60:29] view depth of the centre, back to front (compositing needs the full value)
+//           [28] filter, [27:12] texture
+//
+// The sort is a stable LSD radix sort, so equal keys keep record order. Texture bits are the
+// order in which submit() first meets each texture, so the order never depends on addresses.
+//
+// Usage per frame: begin(cam) -> add_mesh() per visible mesh instance -> push() per primitive
+// (or push_instances() per instanced batch) -> submit(renderer). Several threads may record at
+// once, each through its own recorder(i); the queue's own add_mesh()/push() go to recorder 0.
+// submit() takes the recorders in index order, so the result does not depend on thread timing.
+// Prepared meshes, commands and sort buffers are reused across frames.
+class RenderQueue {
+  public:
+    struct Item {
+        uint32_t mesh = 0; // add_mesh() slot of the recorder the item is pushed to
+        const sr::gfx::Texture* tex = nullptr;
+        uint32_t index_offset = 0;
+        uint32_t index_count = 0;
+        bool double_sided = false;
+        bool front_face_ccw = true;
+        sr::assets::AlphaMode alpha_mode = sr::assets::AlphaMode::Opaque;
+        float alpha_cutoff = 0.5f;
+        sr::assets::TextureFilter filter = sr::assets::TextureFilter::Nearest;
+        uint8_t layer = 0; // 0..3
+    };
+
+    struct Stats {
+        uint32_t opaque_draws = 0;
+        uint32_t blend_draws = 0;
+        uint32_t texture_changes = 0; // between consecutive draws, as executed
+        uint64_t fragments_shaded = 0;
+    };
+
+    // Records draws for one thread; obtained from recorder() and valid until the next
+    // set_recorder_count().
+    class Recorder {
+      public:
+        // Transforms `mesh` into a reused slot; returns the slot for Item::mesh. With `vertices`
+        // off nothing is transformed yet: prepare_vertices() then transforms what the items will
+        // use (see Renderer::begin_mesh()).
+        uint32_t add_mesh(const Renderer& renderer, const sr::assets::Mesh& mesh,
+                          const sr::math::Mat4& model, bool vertices = true);
+        void prepare_vertices(const Renderer& renderer, uint32_t mesh, const uint32_t* vertices,
+                              size_t count);
+
+        // `center`/`radius` are the primitive's world-space bounds, used for the sort key.
+        void push(const Item& item, const sr::math::Vec3& center, float radius);
+
+        // Instanced draws (Renderer::draw_instances()), sorted as one draw with the bounds of all
+        // the instances: the opaque/cutout primitives with the opaque draws, the blended ones
+        // with the blended draws. `batch` and its arrays must stay valid until submit().
+        void push_instances(const Renderer::InstanceBatch& batch, const sr::math::Vec3& center,
+                            float radius, uint8_t layer = 0);
+
+      private:
+        friend class RenderQueue;
+
+        struct Command {
+            Item item;
+            const Renderer::InstanceBatch* batch = nullptr; // instanced: `item` is unused
+            uint64_t key = 0; // without the texture bits (see submit())
+        };
+
+        void record(Command& c, bool blend, uint8_t layer, const sr::math::Vec3& center,
+                    float radius);
+
+        const RenderQueue* queue_ = nullptr;
+        std::vector<Renderer::PreparedMesh> meshes_;
+        uint32_t mesh_count_ = 0;
+        std::vector<Command> commands_;
+    };
+
+    RenderQueue() { set_recorder_count(1); }
+
+    // Sorting on by default; off executes in record order (layers and blend still apply). What
+    // the order saves is fragments_shaded with it off minus with it on, for the same frame
+    // (bench/draw_order_bench.cpp measures that).
+    void set_sorting(bool enabled) { sorting_ = enabled; }
+    bool sorting() const { return sorting_; }
+
+    // Number of recorders (at least 1). Not during recording.
+    void set_recorder_count(int count);
+    int recorder_count() const { return int(recorders_.size()); }
+    Recorder& recorder(int i) { return recorders_[size_t(i)]; }
+
+    void begin(const Camera& cam);
+
+    // Recorder 0.
+    uint32_t add_mesh(const Renderer& renderer, const sr::assets::Mesh& mesh,
+                      const sr::math::Mat4& model, bool vertices = true) {
+        return recorders_[0].add_mesh(renderer, mesh, model, vertices);
+    }
+    void prepare_vertices(const Renderer& renderer, uint32_t mesh, const uint32_t* vertices,
+                          size_t count) {
+        recorders_[0].prepare_vertices(renderer, mesh, vertices, count);
+    }
+    void push(const Item& item, const sr::math::Vec3& center, float radius) {
+        recorders_[0].push(item, center, radius);
+    }
+    void push_instances(const Renderer::InstanceBatch& batch, const sr::math::Vec3& center,
+                        float radius, uint8_t layer = 0) {
+        recorders_[0].push_instances(batch, center, radius, layer);
+    }
+
+    // Sorts, draws everything and flushes the renderer.
+    void submit(Renderer& renderer);
+
+    const Stats& stats() const { return stats_; }
+
+  private:
+    struct SortEntry {
+        uint64_t key = 0;
+        uint32_t recorder = 0;
+        uint32_t command = 0;
+    };
+
+    struct TextureSlot {
+        const sr::gfx::Texture* tex = nullptr;
+        uint32_t frame = 0; // slot is empty unless it equals tex_frame_
+        uint32_t id = 0;
+    };
+
+    // Dense id of `tex` for this submit(), assigned in first-seen order.
+    uint32_t texture_id(const sr::gfx::Texture* tex);
+
+    Camera cam_;
+    sr::math::Mat4 view_ = sr::math::Mat4::identity();
+    std::vector<Recorder> recorders_;
+
+    std::vector<SortEntry> sorted_;
+    std::vector<SortEntry> sort_tmp_;
+    std::vector<TextureSlot> tex_slots_; // open addressing, power-of-two size
+    uint32_t tex_frame_ = 0;
+    uint32_t tex_count_ = 0;
+
+    bool sorting_ = true;
+    Stats stats_;
+};
+
+} // namespace sr::render
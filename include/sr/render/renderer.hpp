@@ -2,6 +2,7 @@
 
 #include "sr/assets/material.hpp"
 #include "sr/assets/mesh.hpp"
+#include "sr/assets/model.hpp"
 #include "sr/gfx/depthbuffer.hpp"
 #include "sr/gfx/framebuffer.hpp"
 #include "sr/gfx/texture.hpp"
@@ -9,10 +10,16 @@
 #include "sr/math/vec2.hpp"
 #include "sr/math/vec3.hpp"
 #include "sr/math/vec4.hpp"
+#include "sr/render/raster.hpp"
 
 #include <cstdint>
+#include <limits>
 #include <vector>
 
+namespace sr::platform {
+class WorkerPool;
+}
+
 namespace sr::render {
 
 namespace detail {
@@ -20,6 +27,58 @@ struct ClipVert {
     sr::math::Vec4 clip{};
     sr::math::Vec2 uv{};
 };
+
+// A triangle clipped by up to six planes has at most 3 + 6 vertices.
+constexpr int kMaxClipVerts = 9;
+
+// Fixed-capacity polygon so clipping never touches the heap.
+struct ClipPoly {
+    ClipVert v[kMaxClipVerts];
+    int count = 0;
+};
+
+// Clip-space outcode bits. Bits 0-5 are the frustum planes (one bit per plane, in clip order);
+// kClipGuard marks a vertex outside the X/Y guard band.
+enum ClipBits : uint8_t {
+    kClipLeft = 1u << 0,
+    kClipRight = 1u << 1,
+    kClipBottom = 1u << 2,
+    kClipTop = 1u << 3,
+    kClipNear = 1u << 4,
+    kClipFar = 1u << 5,
+    kClipGuard = 1u << 6,
+    kClipFrustum = 0x3Fu,
+};
+
+// Guard band half-extent in NDC units. Triangles whose vertices all lie within it skip X/Y
+// clipping and rely on the raster scissor; 8x keeps snapped coordinates far inside the fixed-point
+// range at any supported resolution.
+constexpr float kGuardBand = 8.0f;
+
+// `far_w` is the far plane as a multiple of w: 1 for DepthMapping::Standard, 0 for ReverseZ.
+inline float far_w(sr::math::DepthMapping mapping) {
+    return mapping == sr::math::DepthMapping::ReverseZ ? 0.0f : 1.0f;
+}
+
+inline uint8_t clip_outcode(const sr::math::Vec4& c, float far_w = 1.0f) {
+    uint8_t code = 0;
+    if (c.x < -c.w)
+        code |= kClipLeft;
+    if (c.x > c.w)
+        code |= kClipRight;
+    if (c.y < -c.w)
+        code |= kClipBottom;
+    if (c.y > c.w)
+        code |= kClipTop;
+    if (c.z < -c.w)
+        code |= kClipNear;
+    if (c.z > far_w * c.w)
+        code |= kClipFar;
+    const float g = kGuardBand * c.w;
+    if (!(c.x >= -g && c.x <= g && c.y >= -g && c.y <= g))
+        code |= kClipGuard;
+    return code;
+}
 } // namespace detail
 
 struct Camera {
@@ -30,55 +89,293 @@ struct Camera {
     float fov_y_rad = 1.04719755f; // 60 deg
     float z_near = 0.1f;
     float z_far = 200.0f;
+    sr::math::DepthMapping depth_mapping = sr::math::DepthMapping::Standard;
 };
 
+// proj * view for `cam` on a viewport of the given aspect (what prepare_mesh() transforms with).
+inline sr::math::Mat4 view_proj(const Camera& cam, float aspect) {
+    const sr::math::Mat4 view = sr::math::Mat4::look_at(cam.eye, cam.target, cam.up);
+    const sr::math::Mat4 proj = sr::math::Mat4::perspective(cam.fov_y_rad, aspect, cam.z_near,
+                                                            cam.z_far, cam.depth_mapping);
+    return sr::math::mul(proj, view);
+}
+
 class Renderer {
   public:
-    Renderer(sr::gfx::Framebuffer& fb, sr::gfx::DepthBuffer& zb) : fb_(fb), zb_(zb) {}
+    // Screen tile edge (pixels) used when binning for the worker pool.
+    static constexpr int kTileSize = 64;
+
+    Renderer(sr::gfx::Framebuffer& fb, sr::gfx::DepthBuffer& zb) : fb_(fb), zb_(zb) {
+        set_raster_isa(raster::detect_isa());
+    }
 
+    // With a pool set, draws only bin their triangles into screen tiles; `flush()` then
+    // rasterizes the tiles in parallel (one tile per worker, submission order kept per tile).
+    // Without a pool, draws rasterize immediately on the calling thread.
+    void set_worker_pool(sr::platform::WorkerPool* pool) { pool_ = pool; }
+
+    // Raster kernel ISA; defaults to the best one the CPU supports (see raster::detect_isa()).
+    void set_raster_isa(raster::Isa isa) {
+        isa_ = isa;
+        for (int m = 0; m < kAlphaModeCount; ++m) {
+            const auto mode = sr::assets::AlphaMode(m);
+            for (int s = 0; s < raster::kSamplerCount; ++s) {
+                const auto sampler = raster::Sampler(s);
+                kernels_[m][s] =
+                    raster::kernel_for(isa, mode, raster::Pass::Forward, sampler, zb_.format());
+                vis_kernels_[m][s] = raster::kernel_for(isa, mode, raster::Pass::Visibility,
+                                                        sampler, zb_.format());
+            }
+        }
+    }
+    raster::Isa raster_isa() const { return isa_; }
+
+    // Visibility-buffer (deferred texturing) mode. Opaque/Mask draws only write depth and a
+    // per-pixel triangle id; `flush()` then samples each visible pixel's texture once and
+    // composites Blend draws on top, in submission order. Change it between frames only.
+    void set_visibility_buffer(bool enabled) { vis_ = enabled; }
+    bool visibility_buffer() const { return vis_; }
+
+    // Interlaced rendering: fb/zb hold one field of a `frame_height` frame, its even rows
+    // (`parity` 0) or odd rows (1), so (frame_height + 1) / 2 rows; -1 renders whole frames.
+    // Projection and viewport use the frame's size, so field pixels are exactly the pixels of
+    // those frame rows (mip selection still sees field pixels, a level softer where vertical
+    // minification dominates). Set it before prepare_mesh(); see reconstruct_field() for
+    // rebuilding the frame, which must be `frame_height` rows.
+    void set_field(int parity, int frame_height) {
+        field_ = parity;
+        field_frame_h_ = frame_height;
+    }
+    int field() const { return field_; }
+    // Size of the frame being rendered (the target's, or set_field()'s for a field).
+    int frame_width() const { return fb_.width(); }
+    int frame_height() const { return field_ < 0 ? fb_.height() : field_frame_h_; }
+    float frame_aspect() const { return float(frame_width()) / float(frame_height()); }
+
+    // The depth target; complete after flush().
+    const sr::gfx::DepthBuffer& depth() const { return zb_; }
+
+    // Drops any pending binned triangles (they would be overwritten anyway). The clear itself is
+    // deferred per screen tile: a tile is filled when the first triangle reaches it (by the worker
+    // that rasterizes it, so the fill stays in that core's cache), and flush() fills the tiles
+    // nothing touched in bulk. fb/zb hold the cleared values only after flush().
     void clear(uint32_t argb, float z = std::numeric_limits<float>::infinity());
 
+    // Rasterizes all binned triangles (and resolves the visibility buffer). Call before touching
+    // fb/zb directly (HUD, present).
+    void flush();
+
+    // Fragments that passed the depth test (and were shaded, or written to the visibility
+    // buffer) since the last clear(). Complete after flush().
+    uint64_t fragments_shaded() const { return fragments_; }
+
+    // Per-vertex transform results, computed once and shared by every triangle that references
+    // the vertex. `screen` is only filled for vertices inside near/far and the guard band (the
+    // only ones the unclipped path reads); clipped triangles rebuild theirs from `clip_pos`.
     struct PreparedMesh {
         const sr::assets::Mesh* mesh = nullptr;
+        sr::math::Mat4 mvp;
         std::vector<sr::math::Vec4> clip_pos;
+        std::vector<raster::Vertex> screen;
+        std::vector<uint8_t> outcode; // detail::ClipBits
         bool has_uv = false;
+        float far_w = 1.0f; // detail::far_w() of the camera's depth mapping
+        // prepare_vertices() bookkeeping: vertex i is done when done_pass[i] == pass.
+        std::vector<uint32_t> done_pass;
+        uint32_t pass = 0;
     };
 
     PreparedMesh prepare_mesh(const sr::assets::Mesh& mesh, const sr::math::Mat4& model,
                               const Camera& cam) const;
+    // Same, into `out`, reusing its buffers.
+    void prepare_mesh(const sr::assets::Mesh& mesh, const sr::math::Mat4& model, const Camera& cam,
+                      PreparedMesh& out) const;
+
+    // prepare_mesh() in two steps, for callers that cull below the mesh level: begin_mesh() sets
+    // `out` up without transforming anything, then prepare_vertices() transforms the listed
+    // vertices (e.g. those of the clusters that survived culling), skipping ones already done
+    // since begin_mesh(). Draws may only use indices whose vertices were prepared.
+    void begin_mesh(const sr::assets::Mesh& mesh, const sr::math::Mat4& model, const Camera& cam,
+                    PreparedMesh& out) const;
+    void prepare_vertices(PreparedMesh& prepared, const uint32_t* vertices, size_t count) const;
 
     void
     draw_textured_mesh_prepared(const PreparedMesh& prepared, const sr::gfx::Texture& tex,
                                 uint32_t index_offset = 0, uint32_t index_count = 0,
                                 bool double_sided = false, bool front_face_ccw = true,
                                 sr::assets::AlphaMode alpha_mode = sr::assets::AlphaMode::Opaque,
-                                float alpha_cutoff = 0.5f);
+                                float alpha_cutoff = 0.5f,
+                                sr::assets::TextureFilter filter =
+                                    sr::assets::TextureFilter::Nearest);
+
+    // Parameters of one draw over an index range (as draw_textured_mesh_prepared() takes them).
+    struct DrawParams {
+        const sr::gfx::Texture* tex = nullptr; // null: not drawn
+        uint32_t index_offset = 0;
+        uint32_t index_count = 0;
+        bool double_sided = false;
+        bool front_face_ccw = true;
+        sr::assets::AlphaMode alpha_mode = sr::assets::AlphaMode::Opaque;
+        float alpha_cutoff = 0.5f;
+        sr::assets::TextureFilter filter = sr::assets::TextureFilter::Nearest;
+    };
+
+    // One model placed `count` times, with `draws` holding one entry per model primitive
+    // (normally its index range and material). Nothing is copied: the arrays must outlive the
+    // draw_instances() calls.
+    struct InstanceBatch {
+        const sr::assets::Model* model = nullptr;
+        const sr::math::Mat4* transforms = nullptr;
+        size_t count = 0;
+        const DrawParams* draws = nullptr;
+    };
+
+    // Draws the batch's blended primitives (`blended`) or all the others, instance by instance.
+    // The camera matrices, frustum and each primitive's raster state are set up once per call.
+    // Instances are culled by the model's bounds, then by primitive bounds and, for clustered
+    // models, cluster bounds and normal cones; survivors are transformed one at a time into a
+    // reused buffer, so nothing is allocated per instance. Call the blended pass after every
+    // opaque draw (RenderQueue::push_instances() orders both passes with the other draws).
+    void draw_instances(const InstanceBatch& batch, const Camera& cam, bool blended);
 
     void draw_textured_mesh(const sr::assets::Mesh& mesh, const sr::gfx::Texture& tex,
                             const sr::math::Mat4& model, const Camera& cam,
                             uint32_t index_offset = 0, uint32_t index_count = 0,
                             bool double_sided = false, bool front_face_ccw = true,
                             sr::assets::AlphaMode alpha_mode = sr::assets::AlphaMode::Opaque,
-                            float alpha_cutoff = 0.5f);
+                            float alpha_cutoff = 0.5f,
+                            sr::assets::TextureFilter filter = sr::assets::TextureFilter::Nearest);
 
   private:
-    struct ScreenVert {
-        float x = 0.0f;
-        float y = 0.0f;
-        float z = 0.0f; // NDC z in [-1,1] (smaller is closer)
-        float u_over_w = 0.0f;
-        float v_over_w = 0.0f;
-        float inv_w = 0.0f;
+    using ScreenVert = raster::Vertex;
+    using ClipRect = raster::Rect;
+
+    static constexpr int kAlphaModeCount = 3;
+
+    // Everything the raster needs for one draw call, resolved once: the kernel is already
+    // specialized for the alpha mode and sampler.
+    struct DrawState {
+        raster::State st;
+        raster::KernelFn kernel = nullptr;
+        raster::Sampler sampler = raster::Sampler::Repeat;
+    };
+
+    // Backface handling, resolved per draw into a template argument.
+    enum class Cull : uint8_t {
+        None = 0,   // double-sided
+        BackCcw = 1, // front faces are CCW in NDC
+        BackCw = 2,  // front faces are CW in NDC
+    };
+
+    using DrawRangeFn = void (Renderer::*)(const PreparedMesh& prepared, uint32_t begin,
+                                           uint32_t end, const DrawState& ds, uint32_t state);
+
+    struct BinnedTri {
+        ScreenVert a;
+        ScreenVert b;
+        ScreenVert c;
+        uint32_t state = 0;
+        uint32_t vis_id = 0; // visibility pass: id written for this triangle (0 = forward)
+    };
+
+    // What the resolve pass needs to texture a pixel whose id names this triangle: the raster
+    // setup's UV planes (same origin and evaluation order as the kernels), its unclipped box
+    // (for the per-block mip level) and the texture.
+    struct VisTri {
+        float ox = 0.0f;
+        float oy = 0.0f;
+        ClipRect box;
+        raster::Plane inv_w;
+        raster::Plane u_over_w;
+        raster::Plane v_over_w;
+        const sr::gfx::Texture* tex = nullptr;
+        raster::Sampler sampler = raster::Sampler::Repeat;
     };
 
+    // `fragments` receives the count of fragments that passed the depth test.
     void raster_triangle_textured(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
-                                  const sr::gfx::Texture& tex, sr::assets::AlphaMode alpha_mode,
-                                  float alpha_cutoff);
+                                  const DrawState& ds, const ClipRect& rect, uint64_t& fragments,
+                                  uint32_t vis_id = 0);
 
-    static std::vector<detail::ClipVert> clip_triangle(std::vector<detail::ClipVert> poly);
+    // Triangle loop, one instantiation per (cull, has_uv) pair; see draw_range_for().
+    template <Cull C, bool HasUv>
+    void draw_range(const PreparedMesh& prepared, uint32_t begin, uint32_t end,
+                    const DrawState& ds, uint32_t state);
+    static DrawRangeFn draw_range_for(Cull cull, bool has_uv);
+
+    ScreenVert to_screen(const sr::math::Vec4& clip, const sr::math::Vec2& uv) const;
+    // begin_mesh() with the model-view-projection already multiplied.
+    void begin_mesh_mvp(const sr::assets::Mesh& mesh, const sr::math::Mat4& mvp, float far_w,
+                        PreparedMesh& out) const;
+    // Resolves the raster state for `params` and registers it for binned and deferred
+    // triangles; returns the state index that draw_range() takes.
+    uint32_t bind_draw_state(const DrawParams& params, DrawState& ds);
+    // draw_range() over indices [begin, end) with the winding and culling of `params`.
+    void draw_prepared(const PreparedMesh& prepared, const DrawParams& params, uint32_t begin,
+                       uint32_t end, const DrawState& ds, uint32_t state);
+    // Transforms vertices [0, count), or with Listed the `count` vertices in `list` not yet done.
+    template <bool Listed>
+    void transform_vertices(PreparedMesh& prepared, const uint32_t* list, size_t count) const;
+    template <Cull C>
+    void submit_triangle(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                         const DrawState& ds, uint32_t state);
+
+    void bin_triangle(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                      uint32_t state, uint32_t vis_id = 0);
+    void raster_bins();
+    void reset_bins();
+    // Tile index range (inclusive) of the triangle's conservative pixel box; false if off screen.
+    bool tile_span(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                   ClipRect& tiles) const;
+
+    // Lazy clear (see clear()). clear_tile() only touches tile `t`, so workers may call it for
+    // the tiles they own.
+    void clear_tile(int t);
+    void clear_tiles_under(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c);
+    void clear_untouched_tiles();
+
+    void submit_visible(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                        const DrawState& ds, uint32_t state);
+    void resolve_visibility();
+
+    // Clips against the frustum planes selected by `planes` (kClip* bits), with the far plane at
+    // z = far_w * w (detail::far_w()); returns out.count.
+    static int clip_triangle(const detail::ClipVert& v0, const detail::ClipVert& v1,
+                             const detail::ClipVert& v2, uint8_t planes, float far_w,
+                             detail::ClipPoly& out);
 
     sr::gfx::Framebuffer& fb_;
     sr::gfx::DepthBuffer& zb_;
+
+    raster::Isa isa_ = raster::Isa::Scalar;
+    // Indexed by [AlphaMode][Sampler]; vis_kernels_ is Pass::Visibility (null for Blend).
+    raster::KernelFn kernels_[kAlphaModeCount][raster::kSamplerCount]{};
+    raster::KernelFn vis_kernels_[kAlphaModeCount][raster::kSamplerCount]{};
+
+    sr::platform::WorkerPool* pool_ = nullptr;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    std::vector<DrawState> bin_states_;
+    std::vector<BinnedTri> bin_tris_;
+    std::vector<std::vector<uint32_t>> bins_; // per tile: indices into bin_tris_, in draw order
+    std::vector<uint64_t> tile_fragments_;    // per tile, summed into fragments_ after a pass
+    uint64_t fragments_ = 0;
+
+    std::vector<uint8_t> tile_clear_; // per tile: 1 while clear() is still pending there
+    uint32_t clear_argb_ = 0;
+    float clear_z_ = std::numeric_limits<float>::infinity();
+
+    int field_ = -1;
+    int field_frame_h_ = 0;
+
+    PreparedMesh instance_mesh_;         // draw_instances(): the instance being drawn
+    std::vector<DrawState> instance_ds_; // draw_instances(): per primitive
+    std::vector<uint32_t> instance_state_;
+
+    bool vis_ = false;
+    std::vector<uint32_t> vis_ids_;    // per pixel: index into vis_tris_ + 1 (0 = background)
+    std::vector<VisTri> vis_tris_;     // this frame's visibility-pass triangles
+    std::vector<BinnedTri> vis_blend_; // Blend triangles, composited after the resolve
 };
 
 } // namespace sr::render
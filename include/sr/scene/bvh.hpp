@@ -0,0 +1,156 @@
+#pragma once
+
+#include "sr/math/vec3.hpp"
+#include "sr/render/frustum.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sr::scene {
+
+struct Aabb {
+    sr::math::Vec3 lo{0.0f, 0.0f, 0.0f};
+    sr::math::Vec3 hi{0.0f, 0.0f, 0.0f};
+
+    bool contains(const Aabb& b) const {
+        return lo.x <= b.lo.x && lo.y <= b.lo.y && lo.z <= b.lo.z && hi.x >= b.hi.x &&
+               hi.y >= b.hi.y && hi.z >= b.hi.z;
+    }
+    bool overlaps(const Aabb& b) const {
+        return lo.x <= b.hi.x && lo.y <= b.hi.y && lo.z <= b.hi.z && hi.x >= b.lo.x &&
+               hi.y >= b.lo.y && hi.z >= b.lo.z;
+    }
+    float surface_area() const {
+        const sr::math::Vec3 d = hi - lo;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+inline Aabb merge(const Aabb& a, const Aabb& b) {
+    return Aabb{{std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y), std::min(a.lo.z, b.lo.z)},
+                {std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y), std::max(a.hi.z, b.hi.z)}};
+}
+
+// Dynamic bounding-volume hierarchy over boxes that move (entity world bounds).
+//
+// Leaves store a "fat" box: the given one grown by a tenth of its largest extent per side. While
+// a moved box stays inside its fat box, update() does nothing; otherwise the leaf is re-inserted
+// at the cheapest sibling (by surface area) and the boxes above it are refit. Insertions rotate
+// nodes AVL-style so the height stays logarithmic whatever the insertion order.
+//
+// Queries report the `value` of every leaf whose fat box passes, so they are conservative:
+// callers test their exact bounds afterwards. Report order follows the tree, not insertion.
+class Bvh {
+  public:
+    static constexpr uint32_t kNull = UINT32_MAX;
+
+    // Adds a leaf for `box` reporting `value`; returns its handle.
+    uint32_t insert(const Aabb& box, uint32_t value);
+    void remove(uint32_t leaf);
+    // Moves `leaf` to `box`. Returns true when the tree changed (the box left its fat box).
+    bool update(uint32_t leaf, const Aabb& box);
+    void clear();
+
+    uint32_t value(uint32_t leaf) const { return nodes_[leaf].value; }
+    const Aabb& fat_box(uint32_t leaf) const { return nodes_[leaf].box; }
+    uint32_t leaf_count() const { return leaf_count_; }
+    // 0 when empty, 1 for a single leaf.
+    int height() const { return root_ == kNull ? 0 : nodes_[root_].height + 1; }
+
+    // fn(value) for each leaf whose box overlaps `box`.
+    template <typename Fn> void query(const Aabb& box, Fn&& fn) const {
+        if (root_ != kNull)
+            query_box(root_, box, fn);
+    }
+
+    // fn(value) for each leaf whose box is not entirely outside one of the frustum's planes.
+    // Subtrees inside every plane are reported without further tests.
+    template <typename Fn> void query(const sr::render::Frustum& frustum, Fn&& fn) const {
+        if (root_ != kNull)
+            query_frustum(root_, frustum, kAllPlanes, fn);
+    }
+
+  private:
+    static constexpr uint32_t kAllPlanes = (1u << 6) - 1;
+
+    struct Node {
+        Aabb box;
+        uint32_t parent = kNull; // next free node while on the free list
+        uint32_t child[2] = {kNull, kNull};
+        int height = 0; // 0 for leaves; -1 while free
+        uint32_t value = 0;
+
+        bool leaf() const { return child[0] == kNull; }
+    };
+
+    uint32_t allocate();
+    void release(uint32_t n);
+    void insert_leaf(uint32_t leaf);
+    void remove_leaf(uint32_t leaf);
+    // Refits boxes and heights from `n` up to the root, rebalancing on the way.
+    void refit_up(uint32_t n);
+    uint32_t balance(uint32_t a);
+
+    template <typename Fn> void report_all(uint32_t n, Fn& fn) const {
+        const Node& node = nodes_[n];
+        if (node.leaf()) {
+            fn(node.value);
+            return;
+        }
+        report_all(node.child[0], fn);
+        report_all(node.child[1], fn);
+    }
+
+    template <typename Fn> void query_box(uint32_t n, const Aabb& box, Fn& fn) const {
+        const Node& node = nodes_[n];
+        if (!node.box.overlaps(box))
+            return;
+        if (node.leaf()) {
+            fn(node.value);
+            return;
+        }
+        query_box(node.child[0], box, fn);
+        query_box(node.child[1], box, fn);
+    }
+
+    template <typename Fn>
+    void query_frustum(uint32_t n, const sr::render::Frustum& frustum, uint32_t planes,
+                       Fn& fn) const {
+        const Node& node = nodes_[n];
+        // Per plane still straddled: the box corner farthest along the normal decides "outside",
+        // the nearest one "inside" (the plane is then skipped for the whole subtree).
+        for (uint32_t i = 0; i < 6; ++i) {
+            if (!(planes & (1u << i)))
+                continue;
+            const sr::render::Plane& p = frustum.planes[i];
+            const sr::math::Vec3 far{p.n.x >= 0.0f ? node.box.hi.x : node.box.lo.x,
+                                     p.n.y >= 0.0f ? node.box.hi.y : node.box.lo.y,
+                                     p.n.z >= 0.0f ? node.box.hi.z : node.box.lo.z};
+            if (sr::math::dot(p.n, far) + p.d < 0.0f)
+                return;
+            const sr::math::Vec3 near{p.n.x >= 0.0f ? node.box.lo.x : node.box.hi.x,
+                                      p.n.y >= 0.0f ? node.box.lo.y : node.box.hi.y,
+                                      p.n.z >= 0.0f ? node.box.lo.z : node.box.hi.z};
+            if (sr::math::dot(p.n, near) + p.d >= 0.0f)
+                planes &= ~(1u << i);
+        }
+        if (planes == 0) {
+            report_all(n, fn);
+            return;
+        }
+        if (node.leaf()) {
+            fn(node.value);
+            return;
+        }
+        query_frustum(node.child[0], frustum, planes, fn);
+        query_frustum(node.child[1], frustum, planes, fn);
+    }
+
+    std::vector<Node> nodes_;
+    uint32_t root_ = kNull;
+    uint32_t free_ = kNull;
+    uint32_t leaf_count_ = 0;
+};
+
+} // namespace sr::scene
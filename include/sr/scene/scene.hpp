@@ -3,6 +3,7 @@
 #include "sr/assets/model.hpp"
 #include "sr/math/mat4.hpp"
 #include "sr/render/renderer.hpp"
+#include "sr/scene/bvh.hpp"
 
 #include <memory>
 #include <vector>
@@ -12,11 +13,24 @@ namespace sr::scene {
 struct Entity {
     std::shared_ptr<sr::assets::Model> model;
     sr::math::Mat4 transform = sr::math::Mat4::identity();
+    uint32_t bvh_leaf = Bvh::kNull; // in Scene::bvh; kNull without a model
 };
 
 struct Scene {
     sr::render::Camera camera;
     std::vector<Entity> entities;
+    // World bounds of the entities, reporting their index. Kept current by add_entity() and
+    // set_entity_transform(); code that changes an entity's model or transform directly calls
+    // update_entity_bounds().
+    Bvh bvh;
 };
 
+// The box around the entity's model bounds sphere in world space (what rendering culls by).
+Aabb entity_bounds(const Entity& ent);
+
+// Appends `ent`, adding its bounds to the BVH; returns its index.
+size_t add_entity(Scene& scene, Entity ent);
+void set_entity_transform(Scene& scene, size_t index, const sr::math::Mat4& transform);
+void update_entity_bounds(Scene& scene, size_t index);
+
 } // namespace sr::scene
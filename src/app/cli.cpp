@@ -13,8 +13,18 @@ static void print_help(const char* exe) {
     std::printf("Options:\n");
     std::printf("  --render-w N        Internal render width (default: 720)\n");
     std::printf("  --render-h N        Internal render height (default: 480)\n");
+    std::printf("  --raster-budget MS  Scale the render size down to keep raster time near MS\n");
+    std::printf("  --min-scale F       Smallest dynamic render scale per axis (default: 0.5)\n");
     std::printf("  --window-w N        Window width (default: 1280)\n");
     std::printf("  --window-h N        Window height (default: 720)\n");
+    std::printf("  --threads N         Raster threads, 1 = serial (default: all cores)\n");
+    std::printf("  --no-simd           Force the scalar raster kernel\n");
+    std::printf("  --vis-buffer        Visibility-buffer (deferred texturing) raster\n");
+    std::printf("  --tiled-textures    Store textures in 4x4 texel tiles\n");
+    std::printf("  --depth FORMAT      Z-buffer format: f32, d24s8 or d16 (default: f32)\n");
+    std::printf("  --copy-present      Copy each frame into the SDL texture\n");
+    std::printf("  --no-pipeline       Simulate, render and present each frame back to back\n");
+    std::printf("  --interlace         Rasterize alternate rows, rebuild the rest from history\n");
     std::printf("  --no-fps            Disable FPS overlay\n");
     std::printf("  -h, --help          Show this help\n");
 }
@@ -32,6 +42,19 @@ static bool parse_int(const char* s, int& out) {
     return true;
 }
 
+static bool parse_float(const char* s, float lo, float hi, float& out) {
+    if (!s || !*s)
+        return false;
+    char* end = nullptr;
+    const float v = std::strtof(s, &end);
+    if (!end || *end != '\0')
+        return false;
+    if (!(v > lo && v <= hi))
+        return false;
+    out = v;
+    return true;
+}
+
 } // namespace
 
 bool parse_cli(int argc, char** argv, AppConfig& cfg, AppToggles& toggles) {
@@ -50,6 +73,51 @@ bool parse_cli(int argc, char** argv, AppConfig& cfg, AppToggles& toggles) {
             continue;
         }
 
+        if (std::strcmp(a, "--no-simd") == 0) {
+            cfg.simd = false;
+            continue;
+        }
+
+        if (std::strcmp(a, "--vis-buffer") == 0) {
+            cfg.vis_buffer = true;
+            continue;
+        }
+
+        if (std::strcmp(a, "--copy-present") == 0) {
+            cfg.direct_present = false;
+            continue;
+        }
+
+        if (std::strcmp(a, "--no-pipeline") == 0) {
+            cfg.pipelined = false;
+            continue;
+        }
+
+        if (std::strcmp(a, "--interlace") == 0) {
+            cfg.interlaced = true;
+            continue;
+        }
+
+        if (std::strcmp(a, "--tiled-textures") == 0) {
+            cfg.tiled_textures = true;
+            continue;
+        }
+
+        if (std::strcmp(a, "--depth") == 0) {
+            const char* f = i + 1 < argc ? argv[++i] : "";
+            if (std::strcmp(f, "f32") == 0) {
+                cfg.depth_format = sr::gfx::DepthFormat::F32;
+            } else if (std::strcmp(f, "d24s8") == 0) {
+                cfg.depth_format = sr::gfx::DepthFormat::D24S8;
+            } else if (std::strcmp(f, "d16") == 0) {
+                cfg.depth_format = sr::gfx::DepthFormat::D16;
+            } else {
+                std::fprintf(stderr, "Invalid --depth (expected f32, d24s8 or d16)\n");
+                return false;
+            }
+            continue;
+        }
+
         auto take_int = [&](int& dst) -> bool {
             if (i + 1 >= argc)
                 return false;
@@ -70,6 +138,20 @@ bool parse_cli(int argc, char** argv, AppConfig& cfg, AppToggles& toggles) {
             }
             continue;
         }
+        if (std::strcmp(a, "--raster-budget") == 0) {
+            if (i + 1 >= argc || !parse_float(argv[++i], 0.0f, 1000.0f, cfg.raster_budget_ms)) {
+                std::fprintf(stderr, "Invalid --raster-budget\n");
+                return false;
+            }
+            continue;
+        }
+        if (std::strcmp(a, "--min-scale") == 0) {
+            if (i + 1 >= argc || !parse_float(argv[++i], 0.0f, 1.0f, cfg.min_render_scale)) {
+                std::fprintf(stderr, "Invalid --min-scale\n");
+                return false;
+            }
+            continue;
+        }
         if (std::strcmp(a, "--window-w") == 0) {
             if (!take_int(cfg.window_w)) {
                 std::fprintf(stderr, "Invalid --window-w\n");
@@ -85,6 +167,14 @@ bool parse_cli(int argc, char** argv, AppConfig& cfg, AppToggles& toggles) {
             continue;
         }
 
+        if (std::strcmp(a, "--threads") == 0) {
+            if (!take_int(cfg.render_threads)) {
+                std::fprintf(stderr, "Invalid --threads\n");
+                return false;
+            }
+            continue;
+        }
+
         std::fprintf(stderr, "Unknown option: %s\n", a);
         print_help(argv[0]);
         return false;
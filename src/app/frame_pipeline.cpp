@@ -0,0 +1,205 @@
+#include "app/frame_pipeline.hpp"
+
+#include "app/hud.hpp"
+#include "app/present.hpp"
+
+#include "sr/render/interlace.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace app {
+
+FramePipeline::Slot::Slot(const AppConfig& cfg)
+    : fb(cfg.render_w, cfg.render_h), field(cfg.interlaced ? cfg.render_w : 1,
+                                            cfg.interlaced ? (cfg.render_h + 1) / 2 : 1),
+      zb(cfg.interlaced ? field.width() : cfg.render_w,
+         cfg.interlaced ? field.height() : cfg.render_h, cfg.depth_format),
+      renderer(cfg.interlaced ? field : fb, zb) {
+    if (!cfg.simd)
+        renderer.set_raster_isa(sr::render::raster::Isa::Scalar);
+    renderer.set_visibility_buffer(cfg.vis_buffer);
+}
+
+FramePipeline::FramePipeline(SDL_Renderer* sdl_renderer, const AppConfig& cfg,
+                             sr::platform::WorkerPool* pool)
+    : sdl_renderer_(sdl_renderer), direct_present_(cfg.direct_present),
+      interlaced_(cfg.interlaced), pool_(pool),
+      history_(cfg.interlaced ? cfg.render_w : 1, cfg.interlaced ? cfg.render_h : 1) {
+    const int count = cfg.pipelined ? kMaxInFlight : 1;
+    for (int i = 0; i < count; ++i) {
+        auto s = std::make_unique<Slot>(cfg);
+        s->renderer.set_worker_pool(pool);
+        s->screen = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                      SDL_TEXTUREACCESS_STREAMING, cfg.render_w, cfg.render_h);
+        if (!s->screen)
+            ok_ = false;
+        free_.push_back(s.get());
+        slots_.push_back(std::move(s));
+    }
+    latency_.depth = count;
+    resolution_.budget_ms = cfg.raster_budget_ms;
+    resolution_.min_scale = cfg.min_render_scale;
+    resolution_.max_w = cfg.render_w;
+    resolution_.max_h = cfg.render_h;
+    if (cfg.pipelined)
+        render_thread_ = std::thread([this] { render_main(); });
+}
+
+FramePipeline::~FramePipeline() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    if (render_thread_.joinable())
+        render_thread_.join();
+    for (auto& s : slots_) {
+        if (s->fb.wrapped()) {
+            s->fb.unwrap();
+            SDL_UnlockTexture(s->screen);
+        }
+        if (s->screen)
+            SDL_DestroyTexture(s->screen);
+    }
+}
+
+FrameSnapshot& FramePipeline::acquire(int window_w, int window_h) {
+    while (free_.empty())
+        present_oldest(window_w, window_h);
+    filling_ = free_.back();
+    free_.pop_back();
+    filling_->snap.latency = latency_;
+    filling_->snap.resolution = resolution_;
+    filling_->width = resolution_.width();
+    filling_->height = resolution_.height();
+    return filling_->snap;
+}
+
+void FramePipeline::submit() {
+    Slot* s = filling_;
+    filling_ = nullptr;
+    s->fb.resize(s->width, s->height);
+    if (interlaced_) {
+        s->field.resize(s->width, (s->height + 1) / 2);
+        s->zb.resize(s->width, (s->height + 1) / 2);
+    } else {
+        s->zb.resize(s->width, s->height);
+    }
+    if (direct_present_)
+        begin_direct_frame(s->screen, s->fb);
+    pending_.push_back(s);
+
+    if (!render_thread_.joinable()) {
+        render_slot(*s);
+        s->ready = true;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        work_.push_back(s);
+    }
+    work_cv_.notify_one();
+}
+
+void FramePipeline::present(int window_w, int window_h) {
+    for (;;) {
+        if (pending_.empty())
+            return;
+        bool ready = false;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            ready = pending_.front()->ready;
+        }
+        if (!ready && int(pending_.size()) < kMaxInFlight)
+            return;
+        present_oldest(window_w, window_h);
+    }
+}
+
+void FramePipeline::render_slot(Slot& s) {
+    const auto t0 = std::chrono::steady_clock::now();
+    if (!interlaced_) {
+        render_game(s.renderer, s.queue, occlusion_, s.snap);
+    } else {
+        const sr::render::Camera& cam = s.snap.scene.camera;
+        s.renderer.set_field(field_parity_, s.fb.height());
+        render_game(s.renderer, s.queue, occlusion_, s.snap);
+
+        sr::render::FieldReconstruction in;
+        in.field = &s.field;
+        in.field_depth = &s.zb;
+        in.parity = field_parity_;
+        in.view_proj = sr::render::view_proj(cam, s.renderer.frame_aspect());
+        in.prev_view_proj = history_view_proj_;
+        in.far_z = sr::render::detail::far_w(cam.depth_mapping);
+        in.history = have_history_ ? &history_ : nullptr;
+        sr::render::reconstruct_field(in, s.fb, pool_);
+
+        // Frames render in submission order, so this is always the next frame's predecessor.
+        history_.resize(s.fb.width(), s.fb.height());
+        for (int y = 0; y < s.fb.height(); ++y)
+            std::copy_n(s.fb.row(y), s.fb.width(), history_.row(y));
+        history_view_proj_ = in.view_proj;
+        have_history_ = true;
+        field_parity_ ^= 1;
+    }
+    s.raster_ms =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    hud_draw(s.fb, s.snap.toggles, s.snap.fps, s.queue.stats(), s.snap.latency,
+             s.snap.resolution, occlusion_.stats());
+}
+
+void FramePipeline::render_main() {
+    for (;;) {
+        Slot* s = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            work_cv_.wait(lk, [&] { return stop_ || !work_.empty(); });
+            if (work_.empty())
+                return;
+            s = work_.front();
+            work_.pop_front();
+        }
+        render_slot(*s);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            s->ready = true;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+void FramePipeline::present_oldest(int window_w, int window_h) {
+    Slot* s = pending_.front();
+    pending_.pop_front();
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        done_cv_.wait(lk, [&] { return s->ready; });
+        s->ready = false;
+    }
+    upload_framebuffer(s->screen, s->fb);
+    present_texture(sdl_renderer_, s->screen, window_w, window_h, s->fb.width(), s->fb.height());
+    record_latency(s->snap.input_time);
+    resolution_.update(s->raster_ms);
+    free_.push_back(s);
+}
+
+void FramePipeline::record_latency(std::chrono::steady_clock::time_point input_time) {
+    const auto now = std::chrono::steady_clock::now();
+    const float ms = std::chrono::duration<float, std::milli>(now - input_time).count();
+    if (window_frames_ == 0)
+        window_start_ = now;
+    window_sum_ms_ += double(ms);
+    window_max_ms_ = std::max(window_max_ms_, ms);
+    ++window_frames_;
+    if (now - window_start_ >= std::chrono::seconds(1)) {
+        latency_.avg_ms = float(window_sum_ms_ / double(window_frames_));
+        latency_.max_ms = window_max_ms_;
+        window_sum_ms_ = 0.0;
+        window_max_ms_ = 0.0f;
+        window_frames_ = 0;
+    }
+}
+
+} // namespace app
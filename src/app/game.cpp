@@ -74,12 +74,12 @@ Game init_game(sr::assets::AssetStore& store, const Settings& settings) {
     sr::scene::Entity castle_ent;
     castle_ent.model = g.castle;
     castle_ent.transform = castle_xform;
-    g.scene.entities.push_back(castle_ent);
+    g.castle_entity = int(sr::scene::add_entity(g.scene, castle_ent));
 
     sr::scene::Entity player_ent;
     player_ent.model = g.player_skin->model;
     player_ent.transform = sr::math::Mat4::identity();
-    g.scene.entities.push_back(player_ent);
+    g.player_entity = int(sr::scene::add_entity(g.scene, player_ent));
 
     // Build collider from the scaled/recentered castle.
     g.world_col.build_from_model(*g.castle, castle_xform,
@@ -3,15 +3,39 @@
 #include "sr/gfx/font5x7.hpp"
 
 #include <cstdio>
+#include <cstring>
 
 namespace app {
 
-void hud_draw(sr::gfx::Framebuffer& fb, const AppToggles& toggles, const FpsCounter& fps) {
+void hud_draw(sr::gfx::Framebuffer& fb, const AppToggles& toggles, const FpsCounter& fps,
+              const sr::render::RenderQueue::Stats& stats, const FrameLatency& latency,
+              const DynamicResolution& res, const sr::render::OcclusionCuller::Stats& occlusion) {
     if (!toggles.show_fps)
         return;
     char buf[64];
     std::snprintf(buf, sizeof(buf), "FPS: %.1f", double(fps.value));
     sr::gfx::draw_text_5x7(fb, 8, 8, buf, 0xFFFFFFFFu, 2, 1);
+    std::snprintf(buf, sizeof(buf), "FRAGS: %lluK TEX %u%s",
+                  (unsigned long long)(stats.fragments_shaded / 1000), stats.texture_changes,
+                  toggles.sort_draws ? "" : " UNSORTED");
+    sr::gfx::draw_text_5x7(fb, 8, 26, buf, 0xFFFFFFFFu, 1, 1);
+    std::snprintf(buf, sizeof(buf), "LATENCY: %.1fMS MAX %.1fMS DEPTH %d",
+                  double(latency.avg_ms), double(latency.max_ms), latency.depth);
+    sr::gfx::draw_text_5x7(fb, 8, 36, buf, 0xFFFFFFFFu, 1, 1);
+    std::snprintf(buf, sizeof(buf), "RES: %dX%d RASTER: %.1fMS", fb.width(), fb.height(),
+                  double(res.raster_ms));
+    if (res.budget_ms > 0.0f) {
+        const size_t n = std::strlen(buf);
+        std::snprintf(buf + n, sizeof(buf) - n, " TARGET %.1fMS", double(res.budget_ms));
+    }
+    sr::gfx::draw_text_5x7(fb, 8, 46, buf, 0xFFFFFFFFu, 1, 1);
+    if (toggles.occlusion_cull) {
+        std::snprintf(buf, sizeof(buf), "OCCLUDED: %u/%u MISSED %u", occlusion.culled,
+                      occlusion.tested, occlusion.missed);
+    } else {
+        std::snprintf(buf, sizeof(buf), "OCCLUDED: OFF");
+    }
+    sr::gfx::draw_text_5x7(fb, 8, 56, buf, 0xFFFFFFFFu, 1, 1);
 }
 
 } // namespace app
@@ -39,6 +39,14 @@ InputFrame poll_input(SDL_Renderer* renderer, AppToggles& toggles) {
                 toggles.castle_double_sided = !toggles.castle_double_sided;
             if (e.key.keysym.sym == SDLK_g)
                 toggles.gravity_enabled = !toggles.gravity_enabled;
+            if (e.key.keysym.sym == SDLK_o)
+                toggles.sort_draws = !toggles.sort_draws;
+            if (e.key.keysym.sym == SDLK_f)
+                toggles.bilinear = !toggles.bilinear;
+            if (e.key.keysym.sym == SDLK_z)
+                toggles.reverse_z = !toggles.reverse_z;
+            if (e.key.keysym.sym == SDLK_x)
+                toggles.occlusion_cull = !toggles.occlusion_cull;
         }
 
         if (e.type == SDL_MOUSEMOTION && toggles.mouse_look) {
@@ -1,22 +1,21 @@
 #include "app/app_types.hpp"
 #include "app/cli.hpp"
+#include "app/frame_pipeline.hpp"
 #include "app/game.hpp"
-#include "app/hud.hpp"
 #include "app/input.hpp"
-#include "app/present.hpp"
 #include "app/render.hpp"
 #include "app/settings.hpp"
 #include "app/sim.hpp"
 
-#include "sr/gfx/depthbuffer.hpp"
-#include "sr/gfx/framebuffer.hpp"
 #include "sr/platform/sdl.hpp"
-#include "sr/render/renderer.hpp"
+#include "sr/platform/worker_pool.hpp"
 
 #include <SDL2/SDL.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <memory>
 
 int main(int argc, char** argv) {
     // Always render sharp when scaling.
@@ -36,16 +35,17 @@ int main(int argc, char** argv) {
     wc.title = "software-renderer-cpp";
     sr::platform::SdlApp app(wc);
 
-    sr::gfx::Framebuffer fb(cfg.render_w, cfg.render_h);
-    sr::gfx::DepthBuffer zb(cfg.render_w, cfg.render_h);
-    sr::render::Renderer renderer(fb, zb);
+    std::unique_ptr<sr::platform::WorkerPool> raster_pool;
+    if (cfg.render_threads != 1)
+        raster_pool = std::make_unique<sr::platform::WorkerPool>(cfg.render_threads);
 
-    SDL_Texture* screen = SDL_CreateTexture(app.renderer(), SDL_PIXELFORMAT_ARGB8888,
-                                            SDL_TEXTUREACCESS_STREAMING, fb.width(), fb.height());
-    if (!screen)
+    app::FramePipeline pipeline(app.renderer(), cfg, raster_pool.get());
+    if (!pipeline.ok())
         return 1;
 
     sr::assets::AssetStore store(app.renderer());
+    if (cfg.tiled_textures)
+        store.set_texel_layout(sr::gfx::TexelLayout::Tiled);
     app::Game game = app::init_game(store, settings);
 
     // Apply initial mouse mode.
@@ -59,6 +59,7 @@ int main(int argc, char** argv) {
         last = now;
         dt = std::min(dt, 0.05f);
 
+        const auto input_time = std::chrono::steady_clock::now();
         const app::InputFrame in = app::poll_input(app.renderer(), toggles);
         if (in.quit)
             running = false;
@@ -73,13 +74,14 @@ int main(int argc, char** argv) {
         app::step_game(game, settings, toggles, keys, dt, in.mouse_dx, in.mouse_dy);
 
         fps.tick(dt);
-        app::render_game(renderer, fb, game, toggles, &fps);
-        app::hud_draw(fb, toggles, fps);
-        app::upload_framebuffer(screen, fb);
-        app::present_texture(app.renderer(), screen, app.width(), app.height(), fb.width(),
-                             fb.height());
+        // The render stage reads only the snapshot, so the next step_game() can run meanwhile.
+        app::FrameSnapshot& snap = pipeline.acquire(app.width(), app.height());
+        app::snapshot_game(game, toggles, snap);
+        snap.fps = fps;
+        snap.input_time = input_time;
+        pipeline.submit();
+        pipeline.present(app.width(), app.height());
     }
 
-    SDL_DestroyTexture(screen);
     return 0;
 }
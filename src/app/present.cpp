@@ -7,15 +7,32 @@
 
 namespace app {
 
-void upload_framebuffer(SDL_Texture* screen, const sr::gfx::Framebuffer& fb) {
+bool begin_direct_frame(SDL_Texture* screen, sr::gfx::Framebuffer& fb) {
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(screen, nullptr, &pixels, &pitch) != 0)
+        return false;
+    if (!fb.wrap(pixels, pitch)) {
+        SDL_UnlockTexture(screen);
+        return false;
+    }
+    return true;
+}
+
+void upload_framebuffer(SDL_Texture* screen, sr::gfx::Framebuffer& fb) {
+    if (fb.wrapped()) {
+        // Drawn in place: unlocking hands the pixels to SDL.
+        fb.unwrap();
+        SDL_UnlockTexture(screen);
+        return;
+    }
+
     void* pixels = nullptr;
     int pitch = 0;
     if (SDL_LockTexture(screen, nullptr, &pixels, &pitch) == 0) {
         const int row_bytes = fb.width() * int(sizeof(uint32_t));
-        for (int y = 0; y < fb.height(); ++y) {
-            std::memcpy(static_cast<uint8_t*>(pixels) + y * pitch, fb.pixels() + y * fb.width(),
-                        row_bytes);
-        }
+        for (int y = 0; y < fb.height(); ++y)
+            std::memcpy(static_cast<uint8_t*>(pixels) + y * pitch, fb.row(y), row_bytes);
         SDL_UnlockTexture(screen);
     }
 }
@@ -23,8 +40,9 @@ void upload_framebuffer(SDL_Texture* screen, const sr::gfx::Framebuffer& fb) {
 void present_texture(SDL_Renderer* renderer, SDL_Texture* screen, int window_w, int window_h,
                      int src_w, int src_h) {
     SDL_RenderClear(renderer);
+    const SDL_Rect src{0, 0, src_w, src_h};
     const SDL_Rect dst = app::centered_letterbox_rect(window_w, window_h, src_w, src_h);
-    SDL_RenderCopy(renderer, screen, nullptr, &dst);
+    SDL_RenderCopy(renderer, screen, &src, &dst);
     SDL_RenderPresent(renderer);
 }
 
@@ -4,41 +4,99 @@
 
 #include "sr/math/mat4.hpp"
 #include "sr/math/transform.hpp"
+#include "sr/render/cluster_cull.hpp"
 #include "sr/render/frustum.hpp"
 
 #include <SDL2/SDL.h>
 
 namespace app {
 
-void render_game(sr::render::Renderer& renderer, sr::gfx::Framebuffer& fb, Game& g,
-                 const AppToggles& toggles, FpsCounter* fps) {
+void snapshot_game(const Game& g, const AppToggles& toggles, FrameSnapshot& out) {
+    out.scene.camera = g.scene.camera;
+    out.scene.camera.depth_mapping =
+        toggles.reverse_z ? sr::math::DepthMapping::ReverseZ : sr::math::DepthMapping::Standard;
+    out.scene.entities = g.scene.entities;
+    out.scene.bvh = g.scene.bvh;
+    out.castle = g.castle;
+    out.toggles = toggles;
+
+    const sr::assets::Model* src = g.player_skin ? g.player_skin->model.get() : nullptr;
+    if (!src)
+        return;
+    if (!out.skinned)
+        out.skinned = std::make_shared<sr::assets::Model>();
+    if (out.skinned_source != src) {
+        *out.skinned = *src;
+        out.skinned_source = src;
+    } else {
+        out.skinned->mesh.positions = src->mesh.positions;
+    }
+    for (auto& ent : out.scene.entities) {
+        if (ent.model.get() == src)
+            ent.model = out.skinned;
+    }
+}
+
+void render_game(sr::render::Renderer& renderer, sr::render::RenderQueue& queue,
+                 sr::render::OcclusionCuller& occlusion, const FrameSnapshot& snap) {
+    const sr::render::Camera& cam = snap.scene.camera;
+    const AppToggles& toggles = snap.toggles;
     renderer.clear(app::argb(0xFF, 10, 10, 16));
+    queue.set_sorting(toggles.sort_draws);
+    queue.begin(cam);
 
-    // Frustum cull entities by bounds sphere.
-    const float aspect = float(fb.width()) / float(fb.height());
-    sr::math::Mat4 view =
-        sr::math::Mat4::look_at(g.scene.camera.eye, g.scene.camera.target, g.scene.camera.up);
-    sr::math::Mat4 proj = sr::math::Mat4::perspective(g.scene.camera.fov_y_rad, aspect,
-                                                      g.scene.camera.z_near, g.scene.camera.z_far);
-    sr::math::Mat4 vp = sr::math::mul(proj, view);
-    sr::render::Frustum fr = sr::render::Frustum::from_view_proj(vp);
+    // Frustum cull entities by bounds sphere (at the frame's aspect: the renderer's target may
+    // hold a single interlaced field).
+    const sr::math::Mat4 vp = sr::render::view_proj(cam, renderer.frame_aspect());
+    sr::render::Frustum fr = sr::render::Frustum::from_view_proj(vp, cam.depth_mapping);
 
-    for (const auto& ent : g.scene.entities) {
+    // Then by the boxes around those spheres against last frame's depth. Ids are the entity index
+    // (high half) and primitive index + 1.
+    const bool occlusion_cull = toggles.occlusion_cull;
+    if (occlusion_cull)
+        occlusion.begin(renderer, vp, sr::render::detail::far_w(cam.depth_mapping));
+    else
+        occlusion.reset();
+    auto occluded = [&](uint64_t id, const sr::math::Vec3& c, float r) {
+        const sr::math::Vec3 ext{r, r, r};
+        return occlusion_cull && occlusion.occluded(id, c - ext, c + ext);
+    };
+
+    // Candidates come from walking the scene BVH (the boxes around the same spheres, fattened)
+    // against the frustum, in tree order; the queue orders the draws.
+    const auto& entities = snap.scene.entities;
+    snap.scene.bvh.query(fr, [&](uint32_t e) {
+        const auto& ent = entities[e];
         if (!ent.model)
-            continue;
+            return;
         const auto& model = *ent.model;
 
         sr::math::Vec3 wc = sr::math::transform_point(ent.transform, model.bounds_center);
         float wr = model.bounds_radius * sr::math::max_scale_component(ent.transform);
-        if (!fr.sphere_visible(wc, wr))
-            continue;
+        const uint64_t ent_id = uint64_t(e) << 32;
+        if (!fr.sphere_visible(wc, wr) || occluded(ent_id, wc, wr))
+            return;
 
-        auto prepared = renderer.prepare_mesh(model.mesh, ent.transform, g.scene.camera);
+        // Transformed at the first primitive that survives culling; clustered models only
+        // transform the vertices of clusters that survive theirs.
+        uint32_t mesh_slot = UINT32_MAX;
+        const float scale = sr::math::max_scale_component(ent.transform);
+        const bool clustered = !model.clusters.empty();
+        const sr::render::ClusterView view =
+            clustered ? sr::render::cluster_view(fr, ent.transform, cam.eye)
+                      : sr::render::ClusterView{};
 
-        for (const auto& prim : model.primitives) {
+        for (size_t p = 0; p < model.primitives.size(); ++p) {
+            const auto& prim = model.primitives[p];
             const auto& mat = model.materials.at(prim.material_index);
             if (!mat.base_color_tex)
                 continue;
+            const sr::math::Vec3 pc = sr::math::transform_point(ent.transform, prim.bounds_center);
+            const float pr = prim.bounds_radius * scale;
+            if (occluded(ent_id | (p + 1), pc, pr))
+                continue;
+            if (mesh_slot == UINT32_MAX)
+                mesh_slot = queue.add_mesh(renderer, model.mesh, ent.transform, !clustered);
 
             bool ds = mat.double_sided;
             bool ff = mat.front_face_ccw;
@@ -46,16 +104,42 @@ void render_game(sr::render::Renderer& renderer, sr::gfx::Framebuffer& fb, Game&
                 ds = true;
             if (toggles.flip_winding)
                 ff = !ff;
-            if (ent.model == g.castle && toggles.castle_double_sided)
+            if (ent.model == snap.castle && toggles.castle_double_sided)
                 ds = true;
 
-            renderer.draw_textured_mesh_prepared(prepared, *mat.base_color_tex, prim.index_offset,
-                                                 prim.index_count, ds, ff, mat.alpha_mode,
-                                                 mat.alpha_cutoff);
+            sr::render::RenderQueue::Item item;
+            item.mesh = mesh_slot;
+            item.tex = mat.base_color_tex.get();
+            item.index_offset = prim.index_offset;
+            item.index_count = prim.index_count;
+            item.double_sided = ds;
+            item.front_face_ccw = ff;
+            item.alpha_mode = mat.alpha_mode;
+            item.alpha_cutoff = mat.alpha_cutoff;
+            item.filter = toggles.bilinear ? sr::assets::TextureFilter::Linear : mat.filter;
+            if (!clustered) {
+                queue.push(item, pc, pr);
+                continue;
+            }
+
+            // Each run of consecutive clusters that survive culling is one draw.
+            const uint32_t begin = prim.index_offset;
+            sr::render::for_each_visible_run(
+                view, model, prim, ds, ff, begin, begin + prim.index_count,
+                [&](const uint32_t* list, uint32_t n) {
+                    queue.prepare_vertices(renderer, mesh_slot, list, n);
+                },
+                [&](uint32_t first, uint32_t last) {
+                    item.index_offset = first;
+                    item.index_count = last - first;
+                    queue.push(item, pc, pr);
+                });
         }
-    }
+    });
 
-    (void)fps;
+    queue.submit(renderer);
+    if (occlusion_cull)
+        occlusion.end(renderer);
 }
 
 void present(SDL_Renderer* sdl_renderer, SDL_Texture* screen, const sr::gfx::Framebuffer& fb,
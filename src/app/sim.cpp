@@ -140,8 +140,8 @@ void step_game(Game& g, const Settings& settings, const AppToggles& toggles, con
         g.model_yaw = std::atan2(g.player.vel.x, g.player.vel.z);
     }
     sr::math::Mat4 r = sr::math::Mat4::rotate_y(g.model_yaw);
-    g.scene.entities[g.player_entity].transform =
-        sr::math::mul(t, sr::math::mul(r, g.player_model_offset));
+    sr::scene::set_entity_transform(g.scene, size_t(g.player_entity),
+                                    sr::math::mul(t, sr::math::mul(r, g.player_model_offset)));
 
     // Animation selection:
     // - airborne => jump
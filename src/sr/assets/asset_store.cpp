@@ -11,7 +11,7 @@ std::shared_ptr<sr::gfx::Texture> AssetStore::get_texture(const std::string& pat
             return sp;
     }
 
-    auto tex = std::make_shared<sr::gfx::Texture>(load_texture_rgba8888(renderer_, path));
+    auto tex = std::make_shared<sr::gfx::Texture>(load_texture_rgba8888(renderer_, path, layout_));
     textures_[path] = tex;
     return tex;
 }
@@ -429,6 +429,9 @@ SkinnedModel load_fbx_skinned_model(const std::filesystem::path& path, AssetStor
 
     // Safety: ensure deformed positions vector exists and matches bind count.
     out.model->mesh.positions = out.bind_positions;
+    // Bind-pose bounds; good enough for draw ordering while animating. No clusters: skinning
+    // moves the vertices out of bind-pose cluster bounds and cones.
+    compute_primitive_bounds(*out.model);
 
     // Quick sanity check: if almost all vertices are influenced only by joint 0, skinning will
     // look "nearly static". This usually means the index->vertex mapping was wrong.
@@ -106,7 +106,11 @@ Model load_gltf_model(const std::filesystem::path& path, AssetStore& store,
                 out.base_color = sr::math::Vec3{pbr.base_color_factor[0], pbr.base_color_factor[1],
                                                 pbr.base_color_factor[2]};
                 if (pbr.base_color_texture.texture && pbr.base_color_texture.texture->image) {
-                    const cgltf_image* img = pbr.base_color_texture.texture->image;
+                    const cgltf_texture* tex = pbr.base_color_texture.texture;
+                    // Magnification filter only: minification is handled by the mip chain.
+                    if (tex->sampler && tex->sampler->mag_filter == cgltf_filter_type_linear)
+                        out.filter = TextureFilter::Linear;
+                    const cgltf_image* img = tex->image;
                     if (img->uri) {
                         auto tex_path = resolve_uri(base_dir, img->uri);
                         if (std::filesystem::exists(tex_path))
@@ -233,6 +237,8 @@ Model load_gltf_model(const std::filesystem::path& path, AssetStore& store,
         }
         model.bounds_radius = rad;
     }
+    compute_primitive_bounds(model);
+    build_clusters(model);
 
     cgltf_free(data);
     return model;
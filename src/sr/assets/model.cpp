@@ -0,0 +1,246 @@
+#include "sr/assets/model.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sr::assets {
+
+void compute_primitive_bounds(Model& model) {
+    const auto& pos = model.mesh.positions;
+    const auto& idx = model.mesh.indices;
+    for (auto& prim : model.primitives) {
+        const size_t begin = std::min<size_t>(prim.index_offset, idx.size());
+        const size_t end = std::min<size_t>(begin + prim.index_count, idx.size());
+
+        bool any = false;
+        sr::math::Vec3 mn{0.0f, 0.0f, 0.0f};
+        sr::math::Vec3 mx{0.0f, 0.0f, 0.0f};
+        for (size_t i = begin; i < end; ++i) {
+            if (idx[i] >= pos.size())
+                continue;
+            const sr::math::Vec3& p = pos[idx[i]];
+            if (!any) {
+                mn = p;
+                mx = p;
+                any = true;
+                continue;
+            }
+            mn.x = std::min(mn.x, p.x);
+            mn.y = std::min(mn.y, p.y);
+            mn.z = std::min(mn.z, p.z);
+            mx.x = std::max(mx.x, p.x);
+            mx.y = std::max(mx.y, p.y);
+            mx.z = std::max(mx.z, p.z);
+        }
+        if (!any) {
+            prim.bounds_center = model.bounds_center;
+            prim.bounds_radius = model.bounds_radius;
+            continue;
+        }
+
+        prim.bounds_center = (mn + mx) * 0.5f;
+        float r = 0.0f;
+        for (size_t i = begin; i < end; ++i) {
+            if (idx[i] < pos.size())
+                r = std::max(r, sr::math::length(pos[idx[i]] - prim.bounds_center));
+        }
+        prim.bounds_radius = r;
+    }
+}
+
+namespace {
+
+// Spreads the low 10 bits of v to every third bit.
+uint32_t spread_bits3(uint32_t v) {
+    v &= 0x3FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8)) & 0x0300F00Fu;
+    v = (v | (v << 4)) & 0x030C30C3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+}
+
+// Reorders the triangles of indices [begin, end) so runs of Cluster::kMaxTriangles are compact
+// and face one way: grouped by the axis their normal is closest to (one of six), then along a
+// Morton curve of their centroids over the primitive's bounds.
+void sort_triangles_for_clusters(Model& model, size_t begin, size_t end) {
+    const auto& pos = model.mesh.positions;
+    auto& idx = model.mesh.indices;
+    const size_t tris = (end - begin) / 3;
+    auto vertex = [&](size_t i) { return idx[i] < pos.size() ? pos[idx[i]] : sr::math::Vec3{}; };
+
+    sr::math::Vec3 mn = vertex(begin);
+    sr::math::Vec3 mx = mn;
+    for (size_t i = begin; i < begin + tris * 3; ++i) {
+        const sr::math::Vec3 p = vertex(i);
+        mn = {std::min(mn.x, p.x), std::min(mn.y, p.y), std::min(mn.z, p.z)};
+        mx = {std::max(mx.x, p.x), std::max(mx.y, p.y), std::max(mx.z, p.z)};
+    }
+    const sr::math::Vec3 ext = mx - mn;
+    const float extent = std::max({ext.x, ext.y, ext.z, 1e-20f});
+    auto quantize = [&](float v, float lo) { return uint32_t((v - lo) / extent * 1023.0f); };
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(tris);
+    for (size_t t = 0; t < tris; ++t) {
+        const size_t i = begin + t * 3;
+        const sr::math::Vec3 a = vertex(i);
+        const sr::math::Vec3 b = vertex(i + 1);
+        const sr::math::Vec3 c = vertex(i + 2);
+        const sr::math::Vec3 n = sr::math::cross(b - a, c - a);
+        const float ax = std::fabs(n.x);
+        const float ay = std::fabs(n.y);
+        const float az = std::fabs(n.z);
+        uint32_t axis = 0;
+        if (ax >= ay && ax >= az)
+            axis = n.x < 0.0f ? 1 : 0;
+        else if (ay >= az)
+            axis = n.y < 0.0f ? 3 : 2;
+        else
+            axis = n.z < 0.0f ? 5 : 4;
+        const sr::math::Vec3 m = (a + b + c) / 3.0f;
+        const uint32_t morton = spread_bits3(quantize(m.x, mn.x)) |
+                                (spread_bits3(quantize(m.y, mn.y)) << 1) |
+                                (spread_bits3(quantize(m.z, mn.z)) << 2);
+        keys[t] = {(uint64_t(axis) << 32) | morton, uint32_t(t)};
+    }
+    std::stable_sort(keys.begin(), keys.end(),
+                     [](const auto& l, const auto& r) { return l.first < r.first; });
+
+    std::vector<uint32_t> sorted(tris * 3);
+    for (size_t t = 0; t < tris; ++t) {
+        for (int k = 0; k < 3; ++k)
+            sorted[t * 3 + k] = idx[begin + size_t(keys[t].second) * 3 + k];
+    }
+    std::copy(sorted.begin(), sorted.end(), idx.begin() + std::ptrdiff_t(begin));
+}
+
+// Renumbers vertices in order of first use by the index buffer, so the vertices of each run of
+// triangles sit together in memory. Unreferenced vertices keep their order at the end.
+void order_vertices_by_first_use(Mesh& mesh) {
+    const size_t n = mesh.positions.size();
+    const bool has_uv = mesh.uvs.size() == n;
+    std::vector<uint32_t> remap(n, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t& v : mesh.indices) {
+        if (v >= n)
+            continue;
+        if (remap[v] == UINT32_MAX)
+            remap[v] = next++;
+        v = remap[v];
+    }
+    for (uint32_t& r : remap) {
+        if (r == UINT32_MAX)
+            r = next++;
+    }
+
+    std::vector<sr::math::Vec3> positions(n);
+    for (size_t i = 0; i < n; ++i)
+        positions[remap[i]] = mesh.positions[i];
+    mesh.positions.swap(positions);
+    if (has_uv) {
+        std::vector<sr::math::Vec2> uvs(n);
+        for (size_t i = 0; i < n; ++i)
+            uvs[remap[i]] = mesh.uvs[i];
+        mesh.uvs.swap(uvs);
+    }
+}
+
+} // namespace
+
+void build_clusters(Model& model) {
+    const auto& pos = model.mesh.positions;
+    const auto& idx = model.mesh.indices;
+    model.clusters.clear();
+    model.cluster_vertices.clear();
+    // Last cluster that listed each vertex.
+    std::vector<uint32_t> listed(pos.size(), UINT32_MAX);
+
+    // Blended triangles composite in index order, so only depth-tested ones are reordered.
+    for (const auto& prim : model.primitives) {
+        const size_t begin = std::min<size_t>(prim.index_offset, idx.size());
+        const size_t end = std::min<size_t>(begin + prim.index_count, idx.size());
+        const bool blend = prim.material_index < model.materials.size() &&
+                           model.materials[prim.material_index].alpha_mode == AlphaMode::Blend;
+        if (!blend)
+            sort_triangles_for_clusters(model, begin, end);
+    }
+    order_vertices_by_first_use(model.mesh);
+
+    for (auto& prim : model.primitives) {
+        prim.cluster_offset = uint32_t(model.clusters.size());
+        const size_t begin = std::min<size_t>(prim.index_offset, idx.size());
+        const size_t end = std::min<size_t>(begin + prim.index_count, idx.size());
+        for (size_t c0 = begin; c0 < end; c0 += Cluster::kMaxTriangles * 3) {
+            const size_t c1 = std::min<size_t>(c0 + Cluster::kMaxTriangles * 3, end);
+            const uint32_t id = uint32_t(model.clusters.size());
+            Cluster cl;
+            cl.index_offset = uint32_t(c0);
+            cl.index_count = uint32_t(c1 - c0);
+            cl.vertex_offset = uint32_t(model.cluster_vertices.size());
+
+            sr::math::Vec3 mn{0.0f, 0.0f, 0.0f};
+            sr::math::Vec3 mx{0.0f, 0.0f, 0.0f};
+            for (size_t i = c0; i < c1; ++i) {
+                const uint32_t v = idx[i];
+                if (v >= pos.size() || listed[v] == id)
+                    continue;
+                listed[v] = id;
+                const sr::math::Vec3& p = pos[v];
+                if (model.cluster_vertices.size() == cl.vertex_offset) {
+                    mn = p;
+                    mx = p;
+                }
+                model.cluster_vertices.push_back(v);
+                mn.x = std::min(mn.x, p.x);
+                mn.y = std::min(mn.y, p.y);
+                mn.z = std::min(mn.z, p.z);
+                mx.x = std::max(mx.x, p.x);
+                mx.y = std::max(mx.y, p.y);
+                mx.z = std::max(mx.z, p.z);
+            }
+            cl.vertex_count = uint32_t(model.cluster_vertices.size()) - cl.vertex_offset;
+            // Ascending, so preparing a cluster walks the vertex arrays forwards.
+            std::sort(model.cluster_vertices.begin() + std::ptrdiff_t(cl.vertex_offset),
+                      model.cluster_vertices.end());
+            cl.bounds_center = (mn + mx) * 0.5f;
+            for (uint32_t k = 0; k < cl.vertex_count; ++k) {
+                const sr::math::Vec3& p = pos[model.cluster_vertices[cl.vertex_offset + k]];
+                cl.bounds_radius =
+                    std::max(cl.bounds_radius, sr::math::length(p - cl.bounds_center));
+            }
+
+            // Cone around the mean unit normal; degenerate triangles draw nothing and are skipped.
+            sr::math::Vec3 normals[Cluster::kMaxTriangles];
+            uint32_t n = 0;
+            sr::math::Vec3 sum{0.0f, 0.0f, 0.0f};
+            for (size_t i = c0; i + 2 < c1; i += 3) {
+                if (idx[i] >= pos.size() || idx[i + 1] >= pos.size() || idx[i + 2] >= pos.size())
+                    continue;
+                const sr::math::Vec3& a = pos[idx[i]];
+                const sr::math::Vec3 nrm =
+                    sr::math::cross(pos[idx[i + 1]] - a, pos[idx[i + 2]] - a);
+                const float len = sr::math::length(nrm);
+                if (!(len > 1e-12f))
+                    continue;
+                normals[n] = nrm / len;
+                sum = sum + normals[n];
+                ++n;
+            }
+            const float sum_len = sr::math::length(sum);
+            if (n > 0 && sum_len > 1e-6f) {
+                cl.cone_axis = sum / sum_len;
+                float min_dot = 1.0f;
+                for (uint32_t k = 0; k < n; ++k)
+                    min_dot = std::min(min_dot, sr::math::dot(cl.cone_axis, normals[k]));
+                if (min_dot > 0.0f) {
+                    cl.cone_cos = min_dot;
+                    cl.cone_sin = std::sqrt(std::max(0.0f, 1.0f - min_dot * min_dot));
+                }
+            }
+            model.clusters.push_back(cl);
+        }
+        prim.cluster_count = uint32_t(model.clusters.size()) - prim.cluster_offset;
+    }
+}
+
+} // namespace sr::assets
@@ -235,6 +235,8 @@ Model load_obj_model(const std::filesystem::path& path, AssetStore& store,
         }
         model.bounds_radius = r;
     }
+    compute_primitive_bounds(model);
+    build_clusters(model);
 
     return model;
 }
@@ -9,7 +9,8 @@
 
 namespace sr::assets {
 
-sr::gfx::Texture load_texture_rgba8888(SDL_Renderer* renderer, const std::string& path) {
+sr::gfx::Texture load_texture_rgba8888(SDL_Renderer* renderer, const std::string& path,
+                                       sr::gfx::TexelLayout layout) {
     (void)renderer; // kept for future (GPU textures, etc.)
     SDL_Surface* surf = IMG_Load(path.c_str());
     if (!surf)
@@ -52,8 +53,11 @@ sr::gfx::Texture load_texture_rgba8888(SDL_Renderer* renderer, const std::string
     if (w > 0 && h > 0) {
         non_opaque_frac = float(non_opaque) / float(uint32_t(w) * uint32_t(h));
     }
-    return sr::gfx::Texture(w, h, std::move(pixels), has_alpha, alpha_min, alpha_max,
-                            non_opaque_frac);
+    sr::gfx::Texture tex(w, h, std::move(pixels), has_alpha, alpha_min, alpha_max,
+                         non_opaque_frac);
+    tex.build_mips();
+    tex.set_layout(layout);
+    return tex;
 }
 
 } // namespace sr::assets
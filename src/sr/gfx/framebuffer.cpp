@@ -4,11 +4,52 @@
 
 namespace sr::gfx {
 
-Framebuffer::Framebuffer(int w, int h) : width_(w), height_(h), pixels_(w * h, 0) {
+Framebuffer::Framebuffer(int w, int h)
+    : width_(w), height_(h), stride_(w), max_w_(w), max_h_(h), pixels_(w * h, 0) {
+}
+
+bool Framebuffer::resize(int w, int h) {
+    if (w <= 0 || h <= 0 || w > max_w_ || h > max_h_)
+        return false;
+    width_ = w;
+    height_ = h;
+    return true;
+}
+
+bool Framebuffer::wrap(void* pixels, int pitch_bytes) {
+    if (!pixels || pitch_bytes % int(sizeof(uint32_t)) != 0)
+        return false;
+    const int stride = pitch_bytes / int(sizeof(uint32_t));
+    if (stride < max_w_)
+        return false;
+    external_ = static_cast<uint32_t*>(pixels);
+    stride_ = stride;
+    return true;
+}
+
+void Framebuffer::unwrap() {
+    external_ = nullptr;
+    stride_ = max_w_;
 }
 
 void Framebuffer::clear(uint32_t argb) {
-    std::fill(pixels_.begin(), pixels_.end(), argb);
+    if (stride_ == width_) {
+        std::fill_n(pixels(), size_t(width_) * size_t(height_), argb);
+        return;
+    }
+    for (int y = 0; y < height_; ++y)
+        std::fill_n(row(y), width_, argb);
+}
+
+void Framebuffer::clear_rect(int x0, int y0, int x1, int y1, uint32_t argb) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width_);
+    y1 = std::min(y1, height_);
+    if (x0 >= x1)
+        return;
+    for (int y = y0; y < y1; ++y)
+        std::fill_n(row(y) + x0, x1 - x0, argb);
 }
 
 } // namespace sr::gfx
@@ -1,28 +1,203 @@
 #include "sr/gfx/texture.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 namespace sr::gfx {
 
+namespace {
+
+// Share of texels whose alpha, scaled by `scale`, would pass a 0.5 cutoff.
+float alpha_coverage(const uint32_t* px, size_t n, float scale) {
+    if (n == 0)
+        return 0.0f;
+    size_t pass = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (float(px[i] >> 24) * scale >= 127.5f)
+            ++pass;
+    }
+    return float(pass) / float(n);
+}
+
+// 24.8 fixed-point texel coordinate of `t` (repeat-wrapped), plus one texel so it is never
+// negative and truncation floors. NaN/inf land in range. The SIMD kernels mirror these steps.
+int bilinear_coord(float t, int size) {
+    const float f = t - std::floor(t);
+    const float hi = float(size * 256) + 128.0f;
+    float p = f * float(size * 256) + 128.0f;
+    p = p > 128.0f ? p : 128.0f;
+    p = p < hi ? p : hi;
+    return int(p);
+}
+
+uint32_t lerp_texel(uint32_t a, uint32_t b, uint32_t w) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t ca = (a >> shift) & 0xFFu;
+        const uint32_t cb = (b >> shift) & 0xFFu;
+        out |= ((ca * (256u - w) + cb * w) >> 8) << shift;
+    }
+    return out;
+}
+
+} // namespace
+
+void Texture::build_mips() {
+    // The filter below reads row-major levels.
+    const TexelLayout layout = layout_;
+    set_layout(TexelLayout::Linear);
+    levels_.resize(1);
+    if (width_ <= 0 || height_ <= 0 || pixels_.empty())
+        return;
+    pixels_.resize(size_t(width_) * size_t(height_));
+
+    const bool cutout = likely_cutout();
+    const float coverage0 = cutout ? alpha_coverage(pixels_.data(), pixels_.size(), 1.0f) : 0.0f;
+
+    int w = width_;
+    int h = height_;
+    while (w > 1 || h > 1) {
+        const int nw = std::max(1, w / 2);
+        const int nh = std::max(1, h / 2);
+        const size_t src_off = levels_.back().offset;
+        const size_t dst_off = pixels_.size();
+        pixels_.resize(dst_off + size_t(nw) * size_t(nh));
+        const uint32_t* src = pixels_.data() + src_off;
+        uint32_t* dst = pixels_.data() + dst_off;
+
+        // 2x2 box filter (odd edges repeat their last row/column).
+        for (int y = 0; y < nh; ++y) {
+            const int y0 = std::min(2 * y, h - 1);
+            const int y1 = std::min(2 * y + 1, h - 1);
+            for (int x = 0; x < nw; ++x) {
+                const int x0 = std::min(2 * x, w - 1);
+                const int x1 = std::min(2 * x + 1, w - 1);
+                const uint32_t p[4] = {src[y0 * w + x0], src[y0 * w + x1], src[y1 * w + x0],
+                                       src[y1 * w + x1]};
+                uint32_t out = 0;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 2;
+                    for (uint32_t t : p)
+                        sum += (t >> shift) & 0xFFu;
+                    out |= (sum / 4) << shift;
+                }
+                dst[y * nw + x] = out;
+            }
+        }
+
+        if (cutout) {
+            // Find the alpha scale that restores level 0's cutoff coverage (bisection).
+            const size_t n = size_t(nw) * size_t(nh);
+            float lo = 0.0f;
+            float hi = 4.0f;
+            for (int it = 0; it < 12; ++it) {
+                const float mid = 0.5f * (lo + hi);
+                if (alpha_coverage(dst, n, mid) < coverage0)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                const float a = std::min(255.0f, std::round(float(dst[i] >> 24) * hi));
+                dst[i] = (dst[i] & 0x00FFFFFFu) | (uint32_t(a) << 24);
+            }
+        }
+
+        levels_.push_back(Level{nw, nh, dst_off, 0});
+        w = nw;
+        h = nh;
+    }
+    set_layout(layout);
+}
+
+void Texture::set_layout(TexelLayout layout) {
+    if (layout == layout_)
+        return;
+    if (pixels_.empty()) {
+        layout_ = layout;
+        return;
+    }
+
+    std::vector<Level> levels = levels_;
+    size_t total = 0;
+    for (Level& lv : levels) {
+        lv.offset = total;
+        if (layout == TexelLayout::Tiled) {
+            lv.tiles_x = (lv.width + 3) / 4;
+            total += size_t(lv.tiles_x) * size_t((lv.height + 3) / 4) * 16u;
+        } else {
+            lv.tiles_x = 0;
+            total += size_t(lv.width) * size_t(lv.height);
+        }
+    }
+
+    std::vector<uint32_t> out(total);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const Level& src = levels_[i];
+        const Level& dst = levels[i];
+        if (layout == TexelLayout::Tiled) {
+            // Padding texels repeat the last row/column.
+            const int ph = ((src.height + 3) / 4) * 4;
+            const int pw = dst.tiles_x * 4;
+            for (int y = 0; y < ph; ++y) {
+                const int sy = std::min(y, src.height - 1);
+                for (int x = 0; x < pw; ++x) {
+                    const int sx = std::min(x, src.width - 1);
+                    out[dst.offset +
+                        (size_t(y >> 2) * size_t(dst.tiles_x) + size_t(x >> 2)) * 16u +
+                        size_t(((y & 3) << 2) | (x & 3))] = pixels_[texel_index(src, sx, sy)];
+                }
+            }
+        } else {
+            for (int y = 0; y < src.height; ++y) {
+                for (int x = 0; x < src.width; ++x)
+                    out[dst.offset + size_t(y) * size_t(src.width) + size_t(x)] =
+                        pixels_[texel_index(src, x, y)];
+            }
+        }
+    }
+    pixels_ = std::move(out);
+    levels_ = std::move(levels);
+    layout_ = layout;
+}
+
 uint32_t Texture::sample_repeat(float u, float v) const {
+    return sample_repeat(u, v, 0);
+}
+
+uint32_t Texture::sample_repeat(float u, float v, int level) const {
     if (width_ <= 0 || height_ <= 0 || pixels_.empty())
         return 0;
+    const Level& lv = levels_[size_t(std::clamp(level, 0, int(levels_.size()) - 1))];
+
+    const int x = repeat_texel(u, lv.width);
+    const int y = repeat_texel(v, lv.height);
+    return pixels_[texel_index(lv, x, y)];
+}
+
+uint32_t Texture::sample_bilinear(float u, float v, int level) const {
+    if (width_ <= 0 || height_ <= 0 || pixels_.empty())
+        return 0;
+    const Level& lv = levels_[size_t(std::clamp(level, 0, int(levels_.size()) - 1))];
+
+    const int qx = bilinear_coord(u, lv.width);
+    const int qy = bilinear_coord(v, lv.height);
+    int x0 = (qx >> 8) - 1;
+    int y0 = (qy >> 8) - 1;
+    if (x0 < 0)
+        x0 += lv.width;
+    if (y0 < 0)
+        y0 += lv.height;
+    const int x1 = x0 + 1 < lv.width ? x0 + 1 : 0;
+    const int y1 = y0 + 1 < lv.height ? y0 + 1 : 0;
+    const uint32_t fx = uint32_t(qx & 0xFF);
+    const uint32_t fy = uint32_t(qy & 0xFF);
 
-    // Repeat wrap into [0,1).
-    u = u - std::floor(u);
-    v = v - std::floor(v);
-
-    int x = int(u * float(width_ - 1));
-    int y = int(v * float(height_ - 1));
-    if (x < 0)
-        x = 0;
-    if (y < 0)
-        y = 0;
-    if (x >= width_)
-        x = width_ - 1;
-    if (y >= height_)
-        y = height_ - 1;
-    return pixels_[y * width_ + x];
+    const uint32_t top =
+        lerp_texel(pixels_[texel_index(lv, x0, y0)], pixels_[texel_index(lv, x1, y0)], fx);
+    const uint32_t bottom =
+        lerp_texel(pixels_[texel_index(lv, x0, y1)], pixels_[texel_index(lv, x1, y1)], fx);
+    return lerp_texel(top, bottom, fy);
 }
 
 } // namespace sr::gfx
@@ -0,0 +1,81 @@
+#include "sr/platform/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace sr::platform {
+
+WorkerPool::WorkerPool(int lanes) {
+    if (lanes <= 0)
+        lanes = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads_.reserve(size_t(lanes - 1));
+    for (int i = 0; i + 1 < lanes; ++i)
+        threads_.emplace_back([this] { worker_main(); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+void WorkerPool::run_items() {
+    for (;;) {
+        const int i = next_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= job_count_)
+            return;
+        (*job_)(i);
+    }
+}
+
+void WorkerPool::parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0)
+        return;
+    if (threads_.empty() || count == 1) {
+        for (int i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        job_ = &fn;
+        job_count_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        busy_ = int(threads_.size());
+        generation_ += 1;
+    }
+    wake_cv_.notify_all();
+
+    run_items();
+
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [this] { return busy_ == 0; });
+    job_ = nullptr;
+}
+
+void WorkerPool::worker_main() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_)
+                return;
+            seen = generation_;
+        }
+
+        run_items();
+
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            busy_ -= 1;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+} // namespace sr::platform
@@ -0,0 +1,260 @@
+#include "sr/render/interlace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sr::render {
+namespace {
+
+constexpr int kBandRows = 16;
+
+// ARGB8888 spread to four 16-bit lanes, so per-channel min/max are a few plain integer ops.
+uint64_t spread(uint32_t c) {
+    const uint64_t v = c;
+    return (v & 0xFFu) | ((v & 0xFF00u) << 8) | ((v & 0xFF0000u) << 16) | ((v & 0xFF000000u) << 24);
+}
+
+uint32_t pack(uint64_t v) {
+    return uint32_t((v & 0xFFu) | ((v >> 8) & 0xFF00u) | ((v >> 16) & 0xFF0000u) |
+                    ((v >> 24) & 0xFF000000u));
+}
+
+// All-ones in the lanes where a >= b. Lanes hold at most 255, so (a | 0x8000) - b never borrows
+// from the next lane and its top bit is the comparison.
+uint64_t lanes_ge(uint64_t a, uint64_t b) {
+    constexpr uint64_t kTop = 0x8000800080008000ull;
+    return ((((a | kTop) - b) & kTop) >> 15) * 0xFFFFu;
+}
+
+uint64_t lanes_max(uint64_t a, uint64_t b) {
+    const uint64_t ge = lanes_ge(a, b);
+    return (a & ge) | (b & ~ge);
+}
+
+uint64_t lanes_min(uint64_t a, uint64_t b) {
+    const uint64_t ge = lanes_ge(a, b);
+    return (b & ge) | (a & ~ge);
+}
+
+uint32_t average(uint32_t a, uint32_t b) {
+    // Per-byte (a + b) / 2 without carries between channels.
+    return (a & b) + (((a ^ b) & 0xFEFEFEFEu) >> 1);
+}
+
+// Per-frame constants of the reprojection.
+struct Frame {
+    sr::math::Mat4 reproj; // this frame's NDC -> previous frame's clip space
+    float to_ndc_x = 0.0f;
+    float to_px_x = 0.0f;
+    float to_px_y = 0.0f;
+    float far_z = 1.0f;
+    int w = 0;
+    int h = 0;
+    const sr::gfx::DepthBuffer* zb = nullptr;
+    const sr::gfx::Framebuffer* history = nullptr;
+};
+
+// One missing frame row and its field neighbours.
+struct Row {
+    const uint32_t* above = nullptr;
+    const uint32_t* below = nullptr;
+    const float* za = nullptr; // F32 depth rows read in place; null decodes through get()
+    const float* zc = nullptr;
+    int row_a = 0;
+    int row_b = 0;
+    float ndc_y = 0.0f;
+};
+
+float nearer_depth(const Frame& f, const Row& r, int x) {
+    const float z0 = r.za ? r.za[x] : f.zb->get(x, r.row_a);
+    const float z1 = r.zc ? r.zc[x] : f.zb->get(x, r.row_b);
+    return std::min(std::min(z0, z1), f.far_z);
+}
+
+// History pixel at the reprojected position, or the vertical average when it is off screen.
+uint32_t fetch(const Frame& f, const Row& r, int x, float px, float py) {
+    if (!(px >= 0.0f && px < float(f.w) && py >= 0.0f && py < float(f.h)))
+        return average(r.above[x], r.below[x]);
+    return f.history->row(int(py))[int(px)];
+}
+
+uint32_t reconstruct_pixel(const Frame& f, const Row& r, int x) {
+    uint64_t lo = ~0ull;
+    uint64_t hi = 0;
+    for (int dx = -1; dx <= 1; ++dx) {
+        const int xx = std::clamp(x + dx, 0, f.w - 1);
+        const uint64_t a = spread(r.above[xx]);
+        const uint64_t b = spread(r.below[xx]);
+        lo = lanes_min(lo, lanes_min(a, b));
+        hi = lanes_max(hi, lanes_max(a, b));
+    }
+
+    const float ndc_x = (float(x) + 0.5f) * f.to_ndc_x - 1.0f;
+    const sr::math::Vec4 p =
+        sr::math::mul(f.reproj, sr::math::Vec4{ndc_x, r.ndc_y, nearer_depth(f, r, x), 1.0f});
+    float px = -1.0f;
+    float py = -1.0f;
+    if (p.w > 0.0f) {
+        const float inv_w = 1.0f / p.w;
+        px = (p.x * inv_w + 1.0f) * f.to_px_x;
+        py = (1.0f - p.y * inv_w) * f.to_px_y;
+    }
+    // The average fallback is already inside the range, so clamping it changes nothing.
+    return pack(lanes_min(lanes_max(spread(fetch(f, r, x, px, py)), lo), hi));
+}
+
+#if defined(__SSE2__)
+// Four pixels x..x+3 (1 <= x, x + 4 < w) with the same operations as reconstruct_pixel(), so both
+// give the same bits.
+void reconstruct_4(const Frame& f, const Row& r, int x, uint32_t* dst) {
+    auto load = [](const uint32_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    };
+    const __m128i l = _mm_min_epu8(load(r.above + x - 1), load(r.below + x - 1));
+    const __m128i c = _mm_min_epu8(load(r.above + x), load(r.below + x));
+    const __m128i rr = _mm_min_epu8(load(r.above + x + 1), load(r.below + x + 1));
+    const __m128i lo = _mm_min_epu8(_mm_min_epu8(l, c), rr);
+    const __m128i hl = _mm_max_epu8(load(r.above + x - 1), load(r.below + x - 1));
+    const __m128i hc = _mm_max_epu8(load(r.above + x), load(r.below + x));
+    const __m128i hr = _mm_max_epu8(load(r.above + x + 1), load(r.below + x + 1));
+    const __m128i hi = _mm_max_epu8(_mm_max_epu8(hl, hc), hr);
+
+    __m128 z;
+    if (r.za) {
+        z = _mm_min_ps(_mm_min_ps(_mm_loadu_ps(r.za + x), _mm_loadu_ps(r.zc + x)),
+                       _mm_set1_ps(f.far_z));
+    } else {
+        z = _mm_setr_ps(nearer_depth(f, r, x), nearer_depth(f, r, x + 1),
+                        nearer_depth(f, r, x + 2), nearer_depth(f, r, x + 3));
+    }
+    const __m128 xs = _mm_add_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)),
+                                 _mm_set1_ps(0.5f));
+    const __m128 nx = _mm_sub_ps(_mm_mul_ps(xs, _mm_set1_ps(f.to_ndc_x)), _mm_set1_ps(1.0f));
+    const __m128 ny = _mm_set1_ps(r.ndc_y);
+    // Row i of reproj times (nx, ny, z, 1), summed left to right like sr::math::mul().
+    auto dot_row = [&](int i) {
+        const auto& m = f.reproj.m[i];
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0]), nx), _mm_mul_ps(_mm_set1_ps(m[1]), ny));
+        s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(m[2]), z));
+        return _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(m[3]), _mm_set1_ps(1.0f)));
+    };
+    const __m128 pw = dot_row(3);
+    const __m128 inv_w = _mm_div_ps(_mm_set1_ps(1.0f), pw);
+    const __m128 one = _mm_set1_ps(1.0f);
+    alignas(16) float px[4];
+    alignas(16) float py[4];
+    alignas(16) float wv[4];
+    _mm_store_ps(px, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dot_row(0), inv_w), one),
+                                _mm_set1_ps(f.to_px_x)));
+    _mm_store_ps(py, _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(dot_row(1), inv_w)),
+                                _mm_set1_ps(f.to_px_y)));
+    _mm_store_ps(wv, pw);
+
+    alignas(16) uint32_t src[4];
+    for (int k = 0; k < 4; ++k) {
+        src[k] = wv[k] > 0.0f ? fetch(f, r, x + k, px[k], py[k])
+                              : average(r.above[x + k], r.below[x + k]);
+    }
+    const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(src));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_min_epu8(_mm_max_epu8(v, lo), hi));
+}
+#endif
+
+} // namespace
+
+void reconstruct_field(const FieldReconstruction& in, sr::gfx::Framebuffer& out,
+                       sr::platform::WorkerPool* pool) {
+    const sr::gfx::Framebuffer& field = *in.field;
+    const sr::gfx::DepthBuffer& zb = *in.field_depth;
+    const int w = std::min(out.width(), field.width());
+    const int h = out.height();
+    const int field_h = field.height();
+
+    // Inverse of Renderer::to_screen(): pixel centres to NDC and back.
+    Frame f;
+    f.reproj = sr::math::mul(in.prev_view_proj, sr::math::inverse(in.view_proj));
+    f.to_ndc_x = 2.0f / float(std::max(w - 1, 1));
+    f.to_px_x = 0.5f * float(w - 1);
+    f.to_px_y = 0.5f * float(h - 1);
+    f.far_z = in.far_z;
+    f.w = w;
+    f.h = h;
+    f.zb = &zb;
+    f.history = in.history;
+    if (f.history && (f.history->width() != out.width() || f.history->height() != h))
+        f.history = nullptr;
+    const float to_ndc_y = 2.0f / float(std::max(h - 1, 1));
+
+    // Field row holding frame row y, or -1 when y is a missing row or past the field.
+    auto field_row = [&](int y) {
+        if (y < 0 || y >= h || ((y - in.parity) & 1) != 0)
+            return -1;
+        const int k = (y - in.parity) >> 1;
+        return k < field_h ? k : -1;
+    };
+
+    auto reconstruct_rows = [&](int band) {
+        const int y0 = band * kBandRows;
+        const int y1 = std::min(h, y0 + kBandRows);
+        for (int y = y0; y < y1; ++y) {
+            uint32_t* dst = out.row(y);
+            const int k = field_row(y);
+            if (k >= 0) {
+                std::copy_n(field.row(k), w, dst);
+                continue;
+            }
+
+            const int ka = field_row(y - 1);
+            const int kb = field_row(y + 1);
+            if (ka < 0 && kb < 0) {
+                // Only past a field shorter than half the frame: nothing to interpolate from.
+                if (f.history)
+                    std::copy_n(f.history->row(y), w, dst);
+                else
+                    std::fill_n(dst, w, 0xFF000000u);
+                continue;
+            }
+            Row r;
+            r.row_a = ka >= 0 ? ka : kb;
+            r.row_b = kb >= 0 ? kb : ka;
+            r.above = field.row(r.row_a);
+            r.below = field.row(r.row_b);
+            if (!f.history) {
+                for (int x = 0; x < w; ++x)
+                    dst[x] = average(r.above[x], r.below[x]);
+                continue;
+            }
+            if (const float* depth = zb.data()) {
+                r.za = depth + size_t(r.row_a) * size_t(zb.width());
+                r.zc = depth + size_t(r.row_b) * size_t(zb.width());
+            }
+            r.ndc_y = 1.0f - (float(y) + 0.5f) * to_ndc_y;
+
+            int x = 0;
+#if defined(__SSE2__)
+            if (w > 5) {
+                dst[0] = reconstruct_pixel(f, r, 0);
+                for (x = 1; x + 4 < w; x += 4)
+                    reconstruct_4(f, r, x, dst);
+            }
+#endif
+            for (; x < w; ++x)
+                dst[x] = reconstruct_pixel(f, r, x);
+        }
+    };
+
+    const int bands = (h + kBandRows - 1) / kBandRows;
+    if (pool) {
+        pool->parallel_for(bands, reconstruct_rows);
+    } else {
+        for (int b = 0; b < bands; ++b)
+            reconstruct_rows(b);
+    }
+}
+
+} // namespace sr::render
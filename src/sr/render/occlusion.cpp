@@ -0,0 +1,267 @@
+#include "sr/render/occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sr::render {
+namespace {
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+constexpr int kCell = 8; // level-0 cell of the reprojected pyramid, in frame pixels
+// Rounding slack (pixels) when deciding whether a reprojected quad covers a cell, so quads that
+// land exactly on cell edges (a still camera) still count.
+constexpr float kCoverSlack = 0.25f;
+
+// Frame pixel coordinates as Renderer::to_screen() places them (pixel i's centre is i + 0.5).
+float to_screen_x(float ndc_x, int w) {
+    return (ndc_x * 0.5f + 0.5f) * float(w - 1);
+}
+float to_screen_y(float ndc_y, int h) {
+    return (1.0f - (ndc_y * 0.5f + 0.5f)) * float(h - 1);
+}
+
+// True when every fragment the box can produce fails the depth test against `p`. Boxes that
+// cross the near plane or lie off screen count as visible (the frustum test owns those).
+bool box_hidden(const DepthPyramid& p, const sr::math::Mat4& vp, const sr::math::Vec3& lo,
+                const sr::math::Vec3& hi) {
+    float x_min = kInf;
+    float x_max = -kInf;
+    float y_min = kInf;
+    float y_max = -kInf;
+    float z_min = kInf;
+    for (int i = 0; i < 8; ++i) {
+        const sr::math::Vec4 c = sr::math::mul(
+            vp, sr::math::Vec4{(i & 1) ? hi.x : lo.x, (i & 2) ? hi.y : lo.y,
+                               (i & 4) ? hi.z : lo.z, 1.0f});
+        if (c.w <= 1e-5f || c.z < -c.w)
+            return false;
+        const float inv_w = 1.0f / c.w;
+        const float sx = to_screen_x(c.x * inv_w, p.frame_w);
+        const float sy = to_screen_y(c.y * inv_w, p.frame_h);
+        x_min = std::min(x_min, sx);
+        x_max = std::max(x_max, sx);
+        y_min = std::min(y_min, sy);
+        y_max = std::max(y_max, sy);
+        z_min = std::min(z_min, c.z * inv_w);
+    }
+    if (x_max < 0.0f || y_max < 0.0f || x_min > float(p.frame_w) || y_min > float(p.frame_h))
+        return false;
+
+    // One pixel of slack around the covered pixel centres.
+    const int x0 = int(std::floor(std::max(x_min, -1.0f))) - 1;
+    const int x1 = int(std::ceil(std::min(x_max, float(p.frame_w)))) + 1;
+    const int y0 = int(std::floor(std::max(y_min, -1.0f))) - 1;
+    const int y1 = int(std::ceil(std::min(y_max, float(p.frame_h)))) + 1;
+    return z_min >= p.max_depth(x0, y0, x1, y1);
+}
+
+} // namespace
+
+void DepthPyramid::reset(int w, int h) {
+    level_w.clear();
+    level_h.clear();
+    level_offset.clear();
+    size_t n = 0;
+    for (;;) {
+        level_w.push_back(w);
+        level_h.push_back(h);
+        level_offset.push_back(n);
+        n += size_t(w) * size_t(h);
+        if (w == 1 && h == 1)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    z.resize(n);
+}
+
+void DepthPyramid::build() {
+    for (size_t l = 1; l < level_w.size(); ++l) {
+        const int sw = level_w[l - 1];
+        const int sh = level_h[l - 1];
+        const float* src = z.data() + level_offset[l - 1];
+        float* dst = z.data() + level_offset[l];
+        for (int y = 0; y < level_h[l]; ++y) {
+            const float* r0 = src + size_t(2 * y) * size_t(sw);
+            const float* r1 = 2 * y + 1 < sh ? r0 + sw : r0;
+            for (int x = 0; x < level_w[l]; ++x) {
+                const int x1 = std::min(2 * x + 1, sw - 1);
+                dst[y * level_w[l] + x] =
+                    std::max(std::max(r0[2 * x], r0[x1]), std::max(r1[2 * x], r1[x1]));
+            }
+        }
+    }
+}
+
+float DepthPyramid::max_depth(int x0, int y0, int x1, int y1) const {
+    auto cell_x = [&](int x) { return std::clamp(x, 0, frame_w - 1) / cell_w; };
+    auto cell_y = [&](int y) {
+        const int r = std::max(std::clamp(y, 0, frame_h - 1) - y_offset, 0);
+        return std::min(r / cell_h, level_h[0] - 1);
+    };
+    int cx0 = std::min(cell_x(x0), level_w[0] - 1);
+    int cx1 = std::min(cell_x(x1), level_w[0] - 1);
+    int cy0 = cell_y(y0);
+    int cy1 = cell_y(y1);
+
+    // Coarsest level first where the rect spans at most 2x2 cells.
+    size_t l = 0;
+    while (l + 1 < level_w.size() && (cx1 - cx0 > 1 || cy1 - cy0 > 1)) {
+        cx0 >>= 1;
+        cx1 >>= 1;
+        cy0 >>= 1;
+        cy1 >>= 1;
+        ++l;
+    }
+    const float* lz = z.data() + level_offset[l];
+    float m = -kInf;
+    for (int y = cy0; y <= cy1; ++y) {
+        for (int x = cx0; x <= cx1; ++x)
+            m = std::max(m, lz[y * level_w[l] + x]);
+    }
+    return m;
+}
+
+void OcclusionCuller::begin(const Renderer& renderer, const sr::math::Mat4& view_proj,
+                            float far_z) {
+    view_proj_ = view_proj;
+    far_z_ = far_z;
+    culled_.clear();
+    stats_ = Stats{};
+    active_ = have_prev_;
+    if (!active_)
+        return;
+
+    const int w = renderer.frame_width();
+    const int h = renderer.frame_height();
+    cur_.frame_w = w;
+    cur_.frame_h = h;
+    cur_.cell_w = kCell;
+    cur_.cell_h = kCell;
+    cur_.y_offset = 0;
+    cur_.reset((w + kCell - 1) / kCell, (h + kCell - 1) / kCell);
+    const int gw = cur_.level_w[0];
+    const int gh = cur_.level_h[0];
+    float* cells = cur_.level0();
+    std::fill_n(cells, size_t(gw) * size_t(gh), kInf);
+
+    // Splat each 2x2 block of last frame's tiles as a quad at the block's max depth; blocks
+    // overlap by a tile, so any cell within a tile of where it was lies inside one of them. The
+    // surface is nearer than that quad across the whole block, so the quad's farthest corner
+    // hides whatever is behind it, in every cell the quad fully covers.
+    const sr::math::Mat4 reproj = sr::math::mul(view_proj, sr::math::inverse(prev_view_proj_));
+    const DepthPyramid& p = prev_;
+    const int pw = p.level_w[0];
+    const int ph = p.level_h[0];
+    const float to_ndc_x = 2.0f / float(std::max(p.frame_w - 1, 1));
+    const float to_ndc_y = 2.0f / float(std::max(p.frame_h - 1, 1));
+    for (int ty = 0; ty < std::max(ph - 1, 1); ++ty) {
+        const int ty1 = std::min(ty + 1, ph - 1);
+        const float* r0 = p.z.data() + size_t(ty) * size_t(pw);
+        const float* r1 = p.z.data() + size_t(ty1) * size_t(pw);
+        for (int tx = 0; tx < std::max(pw - 1, 1); ++tx) {
+            const int tx1 = std::min(tx + 1, pw - 1);
+            const float z = std::max(std::max(r0[tx], r0[tx1]), std::max(r1[tx], r1[tx1]));
+            if (!(z < prev_far_z_))
+                continue; // some pixel is background
+
+            // Outermost pixel centres of the block, to NDC.
+            const float px0 = float(tx * p.cell_w) + 0.5f;
+            const float px1 = float(std::min((tx1 + 1) * p.cell_w, p.frame_w)) - 0.5f;
+            const float py0 = float(ty * p.cell_h + p.y_offset) + 0.5f;
+            const float py1 = float(std::min((ty1 + 1) * p.cell_h + p.y_offset, p.frame_h)) - 0.5f;
+            const float nx[2] = {px0 * to_ndc_x - 1.0f, px1 * to_ndc_x - 1.0f};
+            const float ny[2] = {1.0f - py0 * to_ndc_y, 1.0f - py1 * to_ndc_y};
+
+            float sx[2][2]; // [row][col], this frame's pixels
+            float sy[2][2];
+            float z_far = -kInf;
+            bool behind = false;
+            for (int j = 0; j < 2 && !behind; ++j) {
+                for (int i = 0; i < 2; ++i) {
+                    const sr::math::Vec4 c =
+                        sr::math::mul(reproj, sr::math::Vec4{nx[i], ny[j], z, 1.0f});
+                    if (c.w <= 1e-5f) {
+                        behind = true;
+                        break;
+                    }
+                    const float inv_w = 1.0f / c.w;
+                    sx[j][i] = to_screen_x(c.x * inv_w, w);
+                    sy[j][i] = to_screen_y(c.y * inv_w, h);
+                    z_far = std::max(z_far, c.z * inv_w);
+                }
+            }
+            if (behind)
+                continue;
+
+            // Axis-aligned rect inside the (convex) quad.
+            const float x_lo = std::max(sx[0][0], sx[1][0]);
+            const float x_hi = std::min(sx[0][1], sx[1][1]);
+            const float y_lo = std::max(sy[0][0], sy[0][1]);
+            const float y_hi = std::min(sy[1][0], sy[1][1]);
+            if (!(x_lo < x_hi && y_lo < y_hi) || x_hi < 0.0f || y_hi < 0.0f)
+                continue;
+            // Cells whose pixel centres all lie in [lo, hi].
+            const float x_end = x_hi + 0.5f + kCoverSlack;
+            const float y_end = y_hi + 0.5f + kCoverSlack;
+            const int cx0 = std::max(0, int(std::ceil((x_lo - 0.5f - kCoverSlack) / kCell)));
+            const int cy0 = std::max(0, int(std::ceil((y_lo - 0.5f - kCoverSlack) / kCell)));
+            for (int cy = cy0; cy < gh && float(std::min((cy + 1) * kCell, h)) <= y_end; ++cy) {
+                for (int cx = cx0; cx < gw && float(std::min((cx + 1) * kCell, w)) <= x_end; ++cx) {
+                    float& c = cells[cy * gw + cx];
+                    c = std::min(c, z_far);
+                }
+            }
+        }
+    }
+    cur_.build();
+}
+
+bool OcclusionCuller::occluded(uint64_t id, const sr::math::Vec3& lo,
+                               const sr::math::Vec3& hi) {
+    ++stats_.tested;
+    if (!active_ || std::binary_search(force_.begin(), force_.end(), id))
+        return false;
+    if (!box_hidden(cur_, view_proj_, lo, hi))
+        return false;
+    culled_.push_back(Culled{id, lo, hi});
+    ++stats_.culled;
+    return true;
+}
+
+void OcclusionCuller::end(const Renderer& renderer) {
+    // This frame's HiZ becomes next frame's source (prev_ was consumed by begin()).
+    const sr::gfx::DepthBuffer& zb = renderer.depth();
+    const int field = renderer.field();
+    prev_.frame_w = renderer.frame_width();
+    prev_.frame_h = renderer.frame_height();
+    prev_.cell_w = sr::gfx::DepthBuffer::kHizTile;
+    prev_.cell_h = sr::gfx::DepthBuffer::kHizTile * (field < 0 ? 1 : 2);
+    prev_.y_offset = field < 0 ? 0 : field;
+    prev_.reset(zb.hiz_width(), zb.hiz_height());
+    std::copy_n(zb.hiz_data(), size_t(zb.hiz_width()) * size_t(zb.hiz_height()), prev_.level0());
+    prev_.build();
+    prev_view_proj_ = view_proj_;
+    prev_far_z_ = far_z_;
+    have_prev_ = true;
+
+    next_force_.clear();
+    for (const Culled& c : culled_) {
+        if (!box_hidden(prev_, view_proj_, c.lo, c.hi))
+            next_force_.push_back(c.id);
+    }
+    std::sort(next_force_.begin(), next_force_.end());
+    force_.swap(next_force_);
+    stats_.missed = uint32_t(force_.size());
+}
+
+void OcclusionCuller::reset() {
+    have_prev_ = false;
+    active_ = false;
+    culled_.clear();
+    force_.clear();
+    stats_ = Stats{};
+}
+
+} // namespace sr::render
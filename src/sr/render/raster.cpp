@@ -0,0 +1,329 @@
+#include "sr/render/raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sr::render::raster {
+
+uint8_t alpha_cut_from_cutoff(float alpha_cutoff) {
+    const float cutoff = std::clamp(alpha_cutoff, 0.0f, 1.0f);
+    return uint8_t(std::lround(cutoff * 255.0f));
+}
+
+namespace {
+
+// Snapped coordinates beyond this (pixels) are rejected; keeps edge products well inside int64.
+constexpr float kMaxCoord = float(1 << 20);
+
+inline int64_t snap(float v) {
+    return int64_t(std::llround(double(v) * double(kSubpixelOne)));
+}
+
+// Floor division by the sub-pixel scale (arithmetic shift, correct for negatives).
+inline int pixel_floor(int64_t v) {
+    return int(v >> kSubpixelBits);
+}
+
+Plane make_plane(float a, float b, float c, float e1x, float e1y, float e2x, float e2y,
+                 float inv_det) {
+    // Solve attr = a + ddx*dx + ddy*dy through the three vertices (e1 = b - a, e2 = c - a).
+    Plane p;
+    p.base = a;
+    p.ddx = ((b - a) * e2y - (c - a) * e1y) * inv_det;
+    p.ddy = ((c - a) * e1x - (b - a) * e2x) * inv_det;
+    return p;
+}
+
+} // namespace
+
+bool setup_triangle(const Vertex& a, const Vertex& b, const Vertex& c, const Rect& rect,
+                    Setup& out) {
+    const Vertex* v[3] = {&a, &b, &c};
+    int64_t X[3];
+    int64_t Y[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!(std::fabs(v[i]->x) < kMaxCoord && std::fabs(v[i]->y) < kMaxCoord))
+            return false;
+        X[i] = snap(v[i]->x);
+        Y[i] = snap(v[i]->y);
+    }
+
+    // Pixel (x,y) has its centre at (x*one + one/2, y*one + one/2) in fixed point; the box only
+    // holds pixels whose centres fall inside the snapped vertex extents.
+    const int64_t half = kSubpixelOne / 2;
+    const int64_t minX = std::min({X[0], X[1], X[2]});
+    const int64_t maxX = std::max({X[0], X[1], X[2]});
+    const int64_t minY = std::min({Y[0], Y[1], Y[2]});
+    const int64_t maxY = std::max({Y[0], Y[1], Y[2]});
+    out.box.x0 = pixel_floor(minX - half + kSubpixelOne - 1);
+    out.box.x1 = pixel_floor(maxX - half);
+    out.box.y0 = pixel_floor(minY - half + kSubpixelOne - 1);
+    out.box.y1 = pixel_floor(maxY - half);
+    out.minx = std::max(rect.x0, out.box.x0);
+    out.maxx = std::min(rect.x1, out.box.x1);
+    out.miny = std::max(rect.y0, out.box.y0);
+    out.maxy = std::min(rect.y1, out.box.y1);
+    if (out.minx > out.maxx || out.miny > out.maxy)
+        return false;
+
+    int64_t area = (X[2] - X[0]) * (Y[1] - Y[0]) - (Y[2] - Y[0]) * (X[1] - X[0]);
+    if (area == 0)
+        return false;
+    // Flip every edge for clockwise triangles so "inside" is always >= 0.
+    const int64_t sign = area > 0 ? 1 : -1;
+    area *= sign;
+
+    // Edge i is opposite vertex i: 0 = b->c, 1 = c->a, 2 = a->b.
+    const int from[3] = {1, 2, 0};
+    const int to[3] = {2, 0, 1};
+    const int64_t px0 = int64_t(out.minx) * kSubpixelOne + half;
+    const int64_t py0 = int64_t(out.miny) * kSubpixelOne + half;
+    for (int i = 0; i < 3; ++i) {
+        const int f = from[i];
+        const int t = to[i];
+        const int64_t ea = (Y[t] - Y[f]) * sign;
+        const int64_t eb = (X[f] - X[t]) * sign;
+        // Top-left rule (y down): the gradient (ea, eb) points into the triangle, so a "left"
+        // edge has ea > 0 and a "top" edge is horizontal with the interior below (eb > 0).
+        // Centres exactly on any other edge belong to the neighbouring triangle.
+        const bool top_left = ea > 0 || (ea == 0 && eb > 0);
+        out.e0[i] = ea * (px0 - X[f]) + eb * (py0 - Y[f]) - (top_left ? 0 : 1);
+        out.e_dx[i] = ea * kSubpixelOne;
+        out.e_dy[i] = eb * kSubpixelOne;
+    }
+
+    // Attribute planes from the snapped positions, so they agree with the coverage test.
+    const float inv_one = 1.0f / float(kSubpixelOne);
+    out.ox = float(X[0]) * inv_one;
+    out.oy = float(Y[0]) * inv_one;
+    const float e1x = float(X[1] - X[0]) * inv_one;
+    const float e1y = float(Y[1] - Y[0]) * inv_one;
+    const float e2x = float(X[2] - X[0]) * inv_one;
+    const float e2y = float(Y[2] - Y[0]) * inv_one;
+    const float inv_det = 1.0f / (e1x * e2y - e2x * e1y);
+    out.z = make_plane(a.z, b.z, c.z, e1x, e1y, e2x, e2y, inv_det);
+    out.inv_w = make_plane(a.inv_w, b.inv_w, c.inv_w, e1x, e1y, e2x, e2y, inv_det);
+    out.u_over_w = make_plane(a.u_over_w, b.u_over_w, c.u_over_w, e1x, e1y, e2x, e2y, inv_det);
+    out.v_over_w = make_plane(a.v_over_w, b.v_over_w, c.v_over_w, e1x, e1y, e2x, e2y, inv_det);
+    out.zmin = std::min({a.z, b.z, c.z});
+    return true;
+}
+
+namespace {
+
+// Largest stored depth in the block, as NDC z. Unorm keys are compared as integers and decoded
+// once; decode(max key) bounds every z that could still pass against them.
+template <sr::gfx::DepthFormat D> float block_max_depth(const Target& t, int bx, int by) {
+    const int x0 = bx * kBlockSize;
+    const int y0 = by * kBlockSize;
+    const int x1 = std::min(x0 + kBlockSize, t.width);
+    const int y1 = std::min(y0 + kBlockSize, t.height);
+    if constexpr (D == sr::gfx::DepthFormat::F32) {
+        float m = -std::numeric_limits<float>::infinity();
+        for (int y = y0; y < y1; ++y) {
+            const float* row = depth_row<D>(t, y);
+            for (int x = x0; x < x1; ++x)
+                m = row[x] > m ? row[x] : m;
+        }
+        return m;
+    } else {
+        uint32_t m = 0;
+        for (int y = y0; y < y1; ++y) {
+            const DepthT<D>* row = depth_row<D>(t, y);
+            for (int x = x0; x < x1; ++x)
+                m = std::max(m, DepthOps<D>::stored_key(row[x]));
+        }
+        return sr::gfx::DepthBuffer::from_unorm(m, DepthOps<D>::kMax);
+    }
+}
+
+} // namespace
+
+void refresh_hiz_block(const Target& t, int bx, int by) {
+    float m;
+    switch (t.depth_format) {
+    case sr::gfx::DepthFormat::D24S8:
+        m = block_max_depth<sr::gfx::DepthFormat::D24S8>(t, bx, by);
+        break;
+    case sr::gfx::DepthFormat::D16:
+        m = block_max_depth<sr::gfx::DepthFormat::D16>(t, bx, by);
+        break;
+    case sr::gfx::DepthFormat::F32:
+    default:
+        m = block_max_depth<sr::gfx::DepthFormat::F32>(t, bx, by);
+        break;
+    }
+    t.hiz[by * t.hiz_width + bx] = m;
+}
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+void kernel_scalar(const Setup& s, const State& st, const Target& t) {
+    uint64_t shaded = 0;
+    for (int by = s.miny / kBlockSize; by <= s.maxy / kBlockSize; ++by) {
+        for (int bx = s.minx / kBlockSize; bx <= s.maxx / kBlockSize; ++bx) {
+            Block b;
+            if (!enter_block(s, t, bx, by, b))
+                continue;
+
+            const int lod = block_lod(s, st, bx, by);
+            bool wrote = false;
+            int64_t r0 = b.e[0];
+            int64_t r1 = b.e[1];
+            int64_t r2 = b.e[2];
+            for (int y = b.y0; y <= b.y1; ++y) {
+                const RowAttrs ra = row_attrs(s, y);
+                uint32_t* crow = out_row<P>(t, y);
+                DepthT<D>* zrow = depth_row<D>(t, y);
+
+                int64_t w0 = r0;
+                int64_t w1 = r1;
+                int64_t w2 = r2;
+                for (int x = b.x0; x <= b.x1; ++x) {
+                    if ((w0 | w1 | w2) >= 0) {
+                        const float dx = (float(x) + 0.5f) - s.ox;
+                        const float z = ra.z + s.z.ddx * dx;
+                        // NDC z: near=-1 is closer than far=+1.
+                        const DepthKey<D> key = DepthOps<D>::key(z);
+                        const float invw = ra.inv_w + s.inv_w.ddx * dx;
+                        if (depth_passes<D>(key, zrow[x]) && invw != 0.0f) {
+                            float u = 0.0f;
+                            float v = 0.0f;
+                            if constexpr (kNeedsUv<M, P>) {
+                                u = (ra.u + s.u_over_w.ddx * dx) / invw;
+                                v = (ra.v + s.v_over_w.ddx * dx) / invw;
+                            }
+                            shade_fragment<M, P, S, D>(crow + x, zrow + x, key, u, v, lod, st);
+                            ++shaded;
+                            wrote = true;
+                        }
+                    }
+                    w0 += s.e_dx[0];
+                    w1 += s.e_dx[1];
+                    w2 += s.e_dx[2];
+                }
+
+                r0 += s.e_dy[0];
+                r1 += s.e_dy[1];
+                r2 += s.e_dy[2];
+            }
+
+            if (kRefreshesHiz<M> && wrote && t.hiz)
+                refresh_hiz_block(t, bx, by);
+        }
+    }
+    if (t.fragments)
+        *t.fragments += shaded;
+}
+
+#define SR_INSTANTIATE_KERNEL(M, P, S)                                                         \
+    template void kernel_scalar<M, P, S, sr::gfx::DepthFormat::F32>(const Setup&, const State&,   \
+                                                                    const Target&);              \
+    template void kernel_scalar<M, P, S, sr::gfx::DepthFormat::D24S8>(const Setup&, const State&, \
+                                                                      const Target&);            \
+    template void kernel_scalar<M, P, S, sr::gfx::DepthFormat::D16>(const Setup&, const State&,   \
+                                                                    const Target&);
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Opaque, Pass::Visibility, Sampler::Repeat)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::Repeat)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNEL(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::Bilinear)
+#undef SR_INSTANTIATE_KERNEL
+
+Isa detect_isa() {
+#if SR_RASTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::Avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return Isa::Sse41;
+#endif
+    return Isa::Scalar;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Sse41:
+        return "sse4.1";
+    case Isa::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+namespace {
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+KernelFn kernel_for_isa(Isa isa) {
+#if SR_RASTER_X86
+    if (isa == Isa::Avx2)
+        return &kernel_avx2<M, P, S, D>;
+    if (isa == Isa::Sse41)
+        return &kernel_sse41<M, P, S, D>;
+#endif
+    (void)isa;
+    return &kernel_scalar<M, P, S, D>;
+}
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S>
+KernelFn kernel_for_depth(Isa isa, sr::gfx::DepthFormat depth) {
+    switch (depth) {
+    case sr::gfx::DepthFormat::D24S8:
+        return kernel_for_isa<M, P, S, sr::gfx::DepthFormat::D24S8>(isa);
+    case sr::gfx::DepthFormat::D16:
+        return kernel_for_isa<M, P, S, sr::gfx::DepthFormat::D16>(isa);
+    case sr::gfx::DepthFormat::F32:
+    default:
+        return kernel_for_isa<M, P, S, sr::gfx::DepthFormat::F32>(isa);
+    }
+}
+
+template <sr::assets::AlphaMode M, Pass P>
+KernelFn kernel_for_mode(Isa isa, Sampler sampler, sr::gfx::DepthFormat depth) {
+    switch (sampler) {
+    case Sampler::RepeatPow2:
+        return kernel_for_depth<M, P, Sampler::RepeatPow2>(isa, depth);
+    case Sampler::Bilinear:
+        return kernel_for_depth<M, P, Sampler::Bilinear>(isa, depth);
+    case Sampler::Repeat:
+    default:
+        return kernel_for_depth<M, P, Sampler::Repeat>(isa, depth);
+    }
+}
+
+} // namespace
+
+KernelFn kernel_for(Isa isa, sr::assets::AlphaMode mode, Pass pass, Sampler sampler,
+                    sr::gfx::DepthFormat depth) {
+    using sr::assets::AlphaMode;
+    if (pass == Pass::Visibility) {
+        if (mode == AlphaMode::Mask)
+            return kernel_for_mode<AlphaMode::Mask, Pass::Visibility>(isa, sampler, depth);
+        // Never samples, so one variant serves every texture.
+        if (mode == AlphaMode::Opaque)
+            return kernel_for_depth<AlphaMode::Opaque, Pass::Visibility, Sampler::Repeat>(isa,
+                                                                                        depth);
+        return nullptr;
+    }
+    switch (mode) {
+    case AlphaMode::Mask:
+        return kernel_for_mode<AlphaMode::Mask, Pass::Forward>(isa, sampler, depth);
+    case AlphaMode::Blend:
+        return kernel_for_mode<AlphaMode::Blend, Pass::Forward>(isa, sampler, depth);
+    case AlphaMode::Opaque:
+    default:
+        return kernel_for_mode<AlphaMode::Opaque, Pass::Forward>(isa, sampler, depth);
+    }
+}
+
+} // namespace sr::render::raster
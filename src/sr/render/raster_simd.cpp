@@ -0,0 +1,514 @@
+#include "sr/render/raster.hpp"
+
+#if SR_RASTER_X86
+
+#include <immintrin.h>
+
+#include <cstddef>
+
+namespace sr::render::raster {
+namespace {
+
+// Edge values are int64 and stepped incrementally (exact, so the start column does not matter);
+// coverage is the sign bit of (w0 | w1 | w2), read with movemask_pd on the 64-bit lanes.
+// Attributes are evaluated from each lane's own pixel centre in the same operation order as
+// kernel_scalar, so every kernel produces the same bits in every tile.
+
+template <int N> struct LaneBuf {
+    alignas(32) float z[N];      // depth keys for DepthFormat::F32
+    alignas(32) uint32_t key[N]; // unorm depth keys for the other formats
+    alignas(32) float u[N];
+    alignas(32) float v[N];
+    alignas(32) uint32_t depth[N]; // partial-group depth loads (float bits for F32)
+    alignas(32) uint32_t texel[N]; // Sampler::Bilinear: already filtered
+};
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D, int N>
+inline void shade_lanes(int mask, uint32_t* crow, DepthT<D>* zrow, int x, const LaneBuf<N>& lb,
+                        int lod, const State& st) {
+    while (mask) {
+        const int k = __builtin_ctz(unsigned(mask));
+        mask &= mask - 1;
+        DepthKey<D> key;
+        if constexpr (D == sr::gfx::DepthFormat::F32)
+            key = lb.z[k];
+        else
+            key = lb.key[k];
+        if constexpr (S == Sampler::Bilinear)
+            shade_texel<M, P, D>(crow + x + k, zrow + x + k, key, lb.texel[k], st);
+        else
+            shade_fragment<M, P, S, D>(crow + x + k, zrow + x + k, key, lb.u[k], lb.v[k], lod,
+                                       st);
+    }
+}
+
+// Depth test for a lane group: all-ones lanes where the fragment's z passes against the stored
+// value. Unorm keys are built with DepthBuffer::to_unorm's exact float steps, compared as
+// (non-negative) int32 and returned in `key` for the depth write. `valid` lanes exist in the
+// row; the rest read as 0 and get masked later.
+
+__attribute__((target("sse4.1"))) inline __m128i depth_key_sse41(__m128 z, uint32_t max) {
+    __m128 d = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f));
+    d = _mm_min_ps(_mm_max_ps(d, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    const __m128i q =
+        _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(d, _mm_set1_ps(float(max))), _mm_set1_ps(0.5f)));
+    return _mm_min_epi32(q, _mm_set1_epi32(int(max)));
+}
+
+template <sr::gfx::DepthFormat D, int N>
+__attribute__((target("sse4.1"))) inline __m128 depth_test_sse41(__m128 z, const DepthT<D>* zrow,
+                                                                 int valid, LaneBuf<N>& lb,
+                                                                 __m128i& key) {
+    using sr::gfx::DepthFormat;
+    if (valid < 4) {
+        for (int k = 0; k < 4; ++k) {
+            if constexpr (D == DepthFormat::F32)
+                lb.depth[k] = k < valid ? __builtin_bit_cast(uint32_t, zrow[k]) : 0u;
+            else
+                lb.depth[k] = k < valid ? uint32_t(zrow[k]) : 0u;
+        }
+    }
+    const auto* pd = reinterpret_cast<const __m128i*>(lb.depth);
+    if constexpr (D == DepthFormat::F32) {
+        const __m128 zbuf =
+            valid < 4 ? _mm_castsi128_ps(_mm_load_si128(pd)) : _mm_loadu_ps(zrow);
+        return _mm_cmplt_ps(z, zbuf);
+    } else {
+        __m128i stored;
+        if (valid < 4)
+            stored = _mm_load_si128(pd);
+        else if constexpr (D == DepthFormat::D16)
+            stored = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(zrow)));
+        else
+            stored = _mm_loadu_si128(reinterpret_cast<const __m128i*>(zrow));
+        if constexpr (D == DepthFormat::D24S8)
+            stored = _mm_srli_epi32(stored, 8);
+        key = depth_key_sse41(z, DepthOps<D>::kMax);
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(stored, key));
+    }
+}
+
+__attribute__((target("avx2"))) inline __m256i depth_key_avx2(__m256 z, uint32_t max) {
+    __m256 d = _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(0.5f)), _mm256_set1_ps(0.5f));
+    d = _mm256_min_ps(_mm256_max_ps(d, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    const __m256i q = _mm256_cvttps_epi32(
+        _mm256_add_ps(_mm256_mul_ps(d, _mm256_set1_ps(float(max))), _mm256_set1_ps(0.5f)));
+    return _mm256_min_epi32(q, _mm256_set1_epi32(int(max)));
+}
+
+// `in_span` masks the lanes inside the block row (masked loads never touch the others).
+template <sr::gfx::DepthFormat D, int N>
+__attribute__((target("avx2"))) inline __m256 depth_test_avx2(__m256 z, const DepthT<D>* zrow,
+                                                              __m256i in_span, int valid,
+                                                              LaneBuf<N>& lb, __m256i& key) {
+    using sr::gfx::DepthFormat;
+    if constexpr (D == DepthFormat::F32) {
+        return _mm256_cmp_ps(z, _mm256_maskload_ps(zrow, in_span), _CMP_LT_OQ);
+    } else {
+        __m256i stored;
+        if constexpr (D == DepthFormat::D16) {
+            if (valid < 8) {
+                for (int k = 0; k < 8; ++k)
+                    lb.depth[k] = k < valid ? uint32_t(zrow[k]) : 0u;
+                stored = _mm256_load_si256(reinterpret_cast<const __m256i*>(lb.depth));
+            } else {
+                stored =
+                    _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(zrow)));
+            }
+        } else {
+            stored = _mm256_srli_epi32(
+                _mm256_maskload_epi32(reinterpret_cast<const int*>(zrow), in_span), 8);
+        }
+        key = depth_key_avx2(z, DepthOps<D>::kMax);
+        return _mm256_castsi256_ps(_mm256_cmpgt_epi32(stored, key));
+    }
+}
+
+// Vector Texture::sample_bilinear: the same float steps for the 24.8 coordinates, then the four
+// taps of every lane are fetched and blended as packed 16-bit channels (two pixels per 128 bits).
+// Every lane's fetch stays in range whatever its UV, so lanes that are masked off need no care.
+
+__attribute__((target("sse4.1"))) inline __m128i bilinear_coord_sse41(__m128 t, int size) {
+    const __m128 lo = _mm_set1_ps(128.0f);
+    const __m128 hi = _mm_set1_ps(float(size * 256) + 128.0f);
+    const __m128 f = _mm_sub_ps(t, _mm_floor_ps(t));
+    __m128 p = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(float(size * 256))), lo);
+    p = _mm_min_ps(_mm_max_ps(p, lo), hi); // NaN -> lo, like the scalar compares
+    return _mm_cvttps_epi32(p);
+}
+
+// Wrapped texel columns (or rows) c0, c1 = c0 + 1 and the 8-bit weight of c1.
+__attribute__((target("sse4.1"))) inline void bilinear_taps_sse41(__m128i q, int size,
+                                                                  __m128i& c0, __m128i& c1,
+                                                                  __m128i& w) {
+    const __m128i n = _mm_set1_epi32(size);
+    const __m128i one = _mm_set1_epi32(1);
+    c0 = _mm_sub_epi32(_mm_srai_epi32(q, 8), one);
+    c0 = _mm_add_epi32(c0, _mm_and_si128(_mm_cmplt_epi32(c0, _mm_setzero_si128()), n));
+    c1 = _mm_add_epi32(c0, one);
+    c1 = _mm_andnot_si128(_mm_cmpeq_epi32(c1, n), c1);
+    w = _mm_and_si128(q, _mm_set1_epi32(0xFF));
+}
+
+__attribute__((target("sse4.1"))) inline __m128i
+texel_index_sse41(const sr::gfx::Texture& tex, const sr::gfx::Texture::Level& lv, __m128i x,
+                  __m128i y) {
+    const __m128i base = _mm_set1_epi32(int(lv.offset));
+    if (tex.layout() == sr::gfx::TexelLayout::Tiled) {
+        const __m128i three = _mm_set1_epi32(3);
+        const __m128i tile = _mm_add_epi32(
+            _mm_mullo_epi32(_mm_srli_epi32(y, 2), _mm_set1_epi32(lv.tiles_x)),
+            _mm_srli_epi32(x, 2));
+        const __m128i in_tile =
+            _mm_or_si128(_mm_slli_epi32(_mm_and_si128(y, three), 2), _mm_and_si128(x, three));
+        return _mm_add_epi32(base, _mm_add_epi32(_mm_slli_epi32(tile, 4), in_tile));
+    }
+    return _mm_add_epi32(base, _mm_add_epi32(_mm_mullo_epi32(y, _mm_set1_epi32(lv.width)), x));
+}
+
+__attribute__((target("sse4.1"))) inline __m128i gather_sse41(const uint32_t* px, __m128i idx) {
+    alignas(16) int32_t i[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(i), idx);
+    return _mm_setr_epi32(int(px[i[0]]), int(px[i[1]]), int(px[i[2]]), int(px[i[3]]));
+}
+
+// Per channel: (a * (256 - w) + b * w) >> 8, w per pixel. Fits 16 bits: at most 255 * 256.
+__attribute__((target("sse4.1"))) inline __m128i lerp_sse41(__m128i a, __m128i b, __m128i w) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k256 = _mm_set1_epi16(256);
+    const __m128i w2 = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+    const __m128i w01 = _mm_unpacklo_epi32(w2, w2); // pixel 0 weight x4, pixel 1 weight x4
+    const __m128i w23 = _mm_unpackhi_epi32(w2, w2);
+    const __m128i lo =
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(k256, w01)),
+                      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w01));
+    const __m128i hi =
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(k256, w23)),
+                      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w23));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+
+__attribute__((target("sse4.1"))) inline __m128i
+sample_bilinear_sse41(const sr::gfx::Texture& tex, int lod, __m128 u, __m128 v) {
+    if (tex.width() <= 0 || tex.height() <= 0)
+        return _mm_setzero_si128();
+    const auto& lv = tex.level(lod);
+    __m128i x0, x1, fx, y0, y1, fy;
+    bilinear_taps_sse41(bilinear_coord_sse41(u, lv.width), lv.width, x0, x1, fx);
+    bilinear_taps_sse41(bilinear_coord_sse41(v, lv.height), lv.height, y0, y1, fy);
+    const uint32_t* px = tex.pixels();
+    const __m128i t00 = gather_sse41(px, texel_index_sse41(tex, lv, x0, y0));
+    const __m128i t10 = gather_sse41(px, texel_index_sse41(tex, lv, x1, y0));
+    const __m128i t01 = gather_sse41(px, texel_index_sse41(tex, lv, x0, y1));
+    const __m128i t11 = gather_sse41(px, texel_index_sse41(tex, lv, x1, y1));
+    return lerp_sse41(lerp_sse41(t00, t10, fx), lerp_sse41(t01, t11, fx), fy);
+}
+
+__attribute__((target("avx2"))) inline __m256i bilinear_coord_avx2(__m256 t, int size) {
+    const __m256 lo = _mm256_set1_ps(128.0f);
+    const __m256 hi = _mm256_set1_ps(float(size * 256) + 128.0f);
+    const __m256 f = _mm256_sub_ps(t, _mm256_floor_ps(t));
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(f, _mm256_set1_ps(float(size * 256))), lo);
+    p = _mm256_min_ps(_mm256_max_ps(p, lo), hi);
+    return _mm256_cvttps_epi32(p);
+}
+
+__attribute__((target("avx2"))) inline void bilinear_taps_avx2(__m256i q, int size, __m256i& c0,
+                                                               __m256i& c1, __m256i& w) {
+    const __m256i n = _mm256_set1_epi32(size);
+    const __m256i one = _mm256_set1_epi32(1);
+    c0 = _mm256_sub_epi32(_mm256_srai_epi32(q, 8), one);
+    c0 = _mm256_add_epi32(c0,
+                          _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), c0), n));
+    c1 = _mm256_add_epi32(c0, one);
+    c1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(c1, n), c1);
+    w = _mm256_and_si256(q, _mm256_set1_epi32(0xFF));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+texel_index_avx2(const sr::gfx::Texture& tex, const sr::gfx::Texture::Level& lv, __m256i x,
+                 __m256i y) {
+    const __m256i base = _mm256_set1_epi32(int(lv.offset));
+    if (tex.layout() == sr::gfx::TexelLayout::Tiled) {
+        const __m256i three = _mm256_set1_epi32(3);
+        const __m256i tile =
+            _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(y, 2),
+                                                _mm256_set1_epi32(lv.tiles_x)),
+                             _mm256_srli_epi32(x, 2));
+        const __m256i in_tile = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(y, three), 2),
+                                                _mm256_and_si256(x, three));
+        return _mm256_add_epi32(base, _mm256_add_epi32(_mm256_slli_epi32(tile, 4), in_tile));
+    }
+    const __m256i row = _mm256_mullo_epi32(y, _mm256_set1_epi32(lv.width));
+    return _mm256_add_epi32(base, _mm256_add_epi32(row, x));
+}
+
+__attribute__((target("avx2"))) inline __m256i lerp_avx2(__m256i a, __m256i b, __m256i w) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i k256 = _mm256_set1_epi16(256);
+    const __m256i w2 = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+    // Unpacks work per 128-bit half: pixels {0,1,4,5} and {2,3,6,7}; packus restores the order.
+    const __m256i wa = _mm256_unpacklo_epi32(w2, w2);
+    const __m256i wb = _mm256_unpackhi_epi32(w2, w2);
+    const __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_sub_epi16(k256, wa)),
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), wa));
+    const __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_sub_epi16(k256, wb)),
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), wb));
+    return _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+sample_bilinear_avx2(const sr::gfx::Texture& tex, int lod, __m256 u, __m256 v) {
+    if (tex.width() <= 0 || tex.height() <= 0)
+        return _mm256_setzero_si256();
+    const auto& lv = tex.level(lod);
+    __m256i x0, x1, fx, y0, y1, fy;
+    bilinear_taps_avx2(bilinear_coord_avx2(u, lv.width), lv.width, x0, x1, fx);
+    bilinear_taps_avx2(bilinear_coord_avx2(v, lv.height), lv.height, y0, y1, fy);
+    const int* px = reinterpret_cast<const int*>(tex.pixels());
+    const __m256i t00 = _mm256_i32gather_epi32(px, texel_index_avx2(tex, lv, x0, y0), 4);
+    const __m256i t10 = _mm256_i32gather_epi32(px, texel_index_avx2(tex, lv, x1, y0), 4);
+    const __m256i t01 = _mm256_i32gather_epi32(px, texel_index_avx2(tex, lv, x0, y1), 4);
+    const __m256i t11 = _mm256_i32gather_epi32(px, texel_index_avx2(tex, lv, x1, y1), 4);
+    return lerp_avx2(lerp_avx2(t00, t10, fx), lerp_avx2(t01, t11, fx), fy);
+}
+
+} // namespace
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+__attribute__((target("sse4.1"))) void kernel_sse41(const Setup& s, const State& st,
+                                                    const Target& t) {
+    const __m128 lane_off = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 ox = _mm_set1_ps(s.ox);
+    const __m128 z_dx = _mm_set1_ps(s.z.ddx);
+    const __m128 iw_dx = _mm_set1_ps(s.inv_w.ddx);
+    const __m128 u_dx = _mm_set1_ps(s.u_over_w.ddx);
+    const __m128 v_dx = _mm_set1_ps(s.v_over_w.ddx);
+    LaneBuf<4> lb{};
+    uint64_t shaded = 0;
+
+    // Two pixels per 128-bit register: lanes {0,1} and {2,3}.
+    __m128i lane01[3];
+    __m128i step2[3];
+    __m128i step4[3];
+    for (int i = 0; i < 3; ++i) {
+        lane01[i] = _mm_set_epi64x(s.e_dx[i], 0);
+        step2[i] = _mm_set1_epi64x(s.e_dx[i] * 2);
+        step4[i] = _mm_set1_epi64x(s.e_dx[i] * 4);
+    }
+
+    for (int by = s.miny / kBlockSize; by <= s.maxy / kBlockSize; ++by) {
+        for (int bx = s.minx / kBlockSize; bx <= s.maxx / kBlockSize; ++bx) {
+            Block b;
+            if (!enter_block(s, t, bx, by, b))
+                continue;
+            const int lod = block_lod(s, st, bx, by);
+
+            bool wrote = false;
+            int64_t row[3] = {b.e[0], b.e[1], b.e[2]};
+            for (int y = b.y0; y <= b.y1; ++y) {
+                const RowAttrs ra = row_attrs(s, y);
+                const __m128 z_row = _mm_set1_ps(ra.z);
+                const __m128 iw_row = _mm_set1_ps(ra.inv_w);
+                uint32_t* crow = out_row<P>(t, y);
+                DepthT<D>* zrow = depth_row<D>(t, y);
+
+                __m128i lo[3];
+                __m128i hi[3];
+                for (int i = 0; i < 3; ++i) {
+                    lo[i] = _mm_add_epi64(_mm_set1_epi64x(row[i]), lane01[i]);
+                    hi[i] = _mm_add_epi64(lo[i], step2[i]);
+                    row[i] += s.e_dy[i];
+                }
+
+                for (int x = b.x0; x <= b.x1; x += 4) {
+                    const __m128i or_lo = _mm_or_si128(_mm_or_si128(lo[0], lo[1]), lo[2]);
+                    const __m128i or_hi = _mm_or_si128(_mm_or_si128(hi[0], hi[1]), hi[2]);
+                    const int outside = _mm_movemask_pd(_mm_castsi128_pd(or_lo)) |
+                                        (_mm_movemask_pd(_mm_castsi128_pd(or_hi)) << 2);
+                    for (int i = 0; i < 3; ++i) {
+                        lo[i] = _mm_add_epi64(lo[i], step4[i]);
+                        hi[i] = _mm_add_epi64(hi[i], step4[i]);
+                    }
+
+                    const int valid = b.x1 - x + 1;
+                    int bits = ~outside & 0xF;
+                    if (valid < 4)
+                        bits &= (1 << valid) - 1;
+                    if (bits == 0)
+                        continue;
+
+                    const __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(float(x)), lane_off), ox);
+                    const __m128 z = _mm_add_ps(z_row, _mm_mul_ps(z_dx, dx));
+                    __m128i key = _mm_setzero_si128();
+                    const __m128 pass = depth_test_sse41<D>(z, zrow + x, valid, lb, key);
+                    const __m128 invw = _mm_add_ps(iw_row, _mm_mul_ps(iw_dx, dx));
+                    const __m128 m = _mm_and_ps(pass, _mm_cmpneq_ps(invw, zero));
+                    bits &= _mm_movemask_ps(m);
+                    if (bits == 0)
+                        continue;
+
+                    if constexpr (D == sr::gfx::DepthFormat::F32)
+                        _mm_store_ps(lb.z, z);
+                    else
+                        _mm_store_si128(reinterpret_cast<__m128i*>(lb.key), key);
+                    if constexpr (kNeedsUv<M, P>) {
+                        // Perspective-correct UV for the whole lane group.
+                        const __m128 uow = _mm_add_ps(_mm_set1_ps(ra.u), _mm_mul_ps(u_dx, dx));
+                        const __m128 vow = _mm_add_ps(_mm_set1_ps(ra.v), _mm_mul_ps(v_dx, dx));
+                        const __m128 u = _mm_div_ps(uow, invw);
+                        const __m128 v = _mm_div_ps(vow, invw);
+                        if constexpr (S == Sampler::Bilinear) {
+                            _mm_store_si128(reinterpret_cast<__m128i*>(lb.texel),
+                                            sample_bilinear_sse41(*st.tex, lod, u, v));
+                        } else {
+                            _mm_store_ps(lb.u, u);
+                            _mm_store_ps(lb.v, v);
+                        }
+                    }
+                    shade_lanes<M, P, S, D>(bits, crow, zrow, x, lb, lod, st);
+                    shaded += uint64_t(__builtin_popcount(unsigned(bits)));
+                    wrote = true;
+                }
+            }
+
+            if (kRefreshesHiz<M> && wrote && t.hiz)
+                refresh_hiz_block(t, bx, by);
+        }
+    }
+    if (t.fragments)
+        *t.fragments += shaded;
+}
+
+template <sr::assets::AlphaMode M, Pass P, Sampler S, sr::gfx::DepthFormat D>
+__attribute__((target("avx2"))) void kernel_avx2(const Setup& s, const State& st,
+                                                 const Target& t) {
+    const __m256 lane_off = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256i lane_idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 ox = _mm256_set1_ps(s.ox);
+    const __m256 z_dx = _mm256_set1_ps(s.z.ddx);
+    const __m256 iw_dx = _mm256_set1_ps(s.inv_w.ddx);
+    const __m256 u_dx = _mm256_set1_ps(s.u_over_w.ddx);
+    const __m256 v_dx = _mm256_set1_ps(s.v_over_w.ddx);
+    LaneBuf<8> lb{};
+    uint64_t shaded = 0;
+
+    // A block row is at most 8 pixels: one group, four pixels per 256-bit register.
+    __m256i lane0123[3];
+    __m256i step4[3];
+    for (int i = 0; i < 3; ++i) {
+        const int64_t d = s.e_dx[i];
+        lane0123[i] = _mm256_setr_epi64x(0, d, d * 2, d * 3);
+        step4[i] = _mm256_set1_epi64x(d * 4);
+    }
+
+    for (int by = s.miny / kBlockSize; by <= s.maxy / kBlockSize; ++by) {
+        for (int bx = s.minx / kBlockSize; bx <= s.maxx / kBlockSize; ++bx) {
+            Block b;
+            if (!enter_block(s, t, bx, by, b))
+                continue;
+            const int lod = block_lod(s, st, bx, by);
+
+            const int x = b.x0;
+            // Lanes past the right edge of the block: masked off and never loaded.
+            const __m256i in_span = _mm256_cmpgt_epi32(_mm256_set1_epi32(b.x1 - x + 1), lane_idx);
+            const int span_bits = _mm256_movemask_ps(_mm256_castsi256_ps(in_span));
+            const __m256 dx = _mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(float(x)), lane_off), ox);
+            const __m256 z_off = _mm256_mul_ps(z_dx, dx);
+            const __m256 iw_off = _mm256_mul_ps(iw_dx, dx);
+
+            bool wrote = false;
+            int64_t row[3] = {b.e[0], b.e[1], b.e[2]};
+            for (int y = b.y0; y <= b.y1; ++y) {
+                __m256i lo[3];
+                __m256i hi[3];
+                for (int i = 0; i < 3; ++i) {
+                    lo[i] = _mm256_add_epi64(_mm256_set1_epi64x(row[i]), lane0123[i]);
+                    hi[i] = _mm256_add_epi64(lo[i], step4[i]);
+                    row[i] += s.e_dy[i];
+                }
+                const __m256i or_lo = _mm256_or_si256(_mm256_or_si256(lo[0], lo[1]), lo[2]);
+                const __m256i or_hi = _mm256_or_si256(_mm256_or_si256(hi[0], hi[1]), hi[2]);
+                const int outside = _mm256_movemask_pd(_mm256_castsi256_pd(or_lo)) |
+                                    (_mm256_movemask_pd(_mm256_castsi256_pd(or_hi)) << 4);
+                int bits = ~outside & span_bits;
+                if (bits == 0)
+                    continue;
+
+                const RowAttrs ra = row_attrs(s, y);
+                uint32_t* crow = out_row<P>(t, y);
+                DepthT<D>* zrow = depth_row<D>(t, y);
+
+                const __m256 z = _mm256_add_ps(_mm256_set1_ps(ra.z), z_off);
+                __m256i key = _mm256_setzero_si256();
+                const __m256 pass =
+                    depth_test_avx2<D>(z, zrow + x, in_span, b.x1 - x + 1, lb, key);
+                const __m256 invw = _mm256_add_ps(_mm256_set1_ps(ra.inv_w), iw_off);
+                const __m256 m = _mm256_and_ps(pass, _mm256_cmp_ps(invw, zero, _CMP_NEQ_UQ));
+                bits &= _mm256_movemask_ps(m);
+                if (bits == 0)
+                    continue;
+
+                if constexpr (D == sr::gfx::DepthFormat::F32)
+                    _mm256_store_ps(lb.z, z);
+                else
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(lb.key), key);
+                if constexpr (kNeedsUv<M, P>) {
+                    // Perspective-correct UV for the whole lane group.
+                    const __m256 uow =
+                        _mm256_add_ps(_mm256_set1_ps(ra.u), _mm256_mul_ps(u_dx, dx));
+                    const __m256 vow =
+                        _mm256_add_ps(_mm256_set1_ps(ra.v), _mm256_mul_ps(v_dx, dx));
+                    const __m256 u = _mm256_div_ps(uow, invw);
+                    const __m256 v = _mm256_div_ps(vow, invw);
+                    if constexpr (S == Sampler::Bilinear) {
+                        _mm256_store_si256(reinterpret_cast<__m256i*>(lb.texel),
+                                           sample_bilinear_avx2(*st.tex, lod, u, v));
+                    } else {
+                        _mm256_store_ps(lb.u, u);
+                        _mm256_store_ps(lb.v, v);
+                    }
+                }
+                shade_lanes<M, P, S, D>(bits, crow, zrow, x, lb, lod, st);
+                shaded += uint64_t(__builtin_popcount(unsigned(bits)));
+                wrote = true;
+            }
+
+            if (kRefreshesHiz<M> && wrote && t.hiz)
+                refresh_hiz_block(t, bx, by);
+        }
+    }
+    if (t.fragments)
+        *t.fragments += shaded;
+}
+
+#define SR_INSTANTIATE_KERNELS_D(M, P, S, D)                                                   \
+    template void kernel_sse41<M, P, S, D>(const Setup&, const State&, const Target&);             \
+    template void kernel_avx2<M, P, S, D>(const Setup&, const State&, const Target&);
+#define SR_INSTANTIATE_KERNELS(M, P, S)                                                        \
+    SR_INSTANTIATE_KERNELS_D(M, P, S, sr::gfx::DepthFormat::F32)                                   \
+    SR_INSTANTIATE_KERNELS_D(M, P, S, sr::gfx::DepthFormat::D24S8)                                 \
+    SR_INSTANTIATE_KERNELS_D(M, P, S, sr::gfx::DepthFormat::D16)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::Repeat)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Opaque, Pass::Visibility, Sampler::Repeat)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::Repeat)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::RepeatPow2)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Opaque, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Blend, Pass::Forward, Sampler::Bilinear)
+SR_INSTANTIATE_KERNELS(sr::assets::AlphaMode::Mask, Pass::Visibility, Sampler::Bilinear)
+#undef SR_INSTANTIATE_KERNELS
+#undef SR_INSTANTIATE_KERNELS_D
+
+} // namespace sr::render::raster
+
+#endif // SR_RASTER_X86
@@ -0,0 +1,226 @@
+#include "sr/render/render_queue.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace sr::render {
+namespace {
+
+constexpr int kLayerShift = 62;
+constexpr int kBlendShift = 61;
+constexpr uint64_t kPassMask = ~0ull << kBlendShift; // layer and blend bits
+constexpr int kOpaqueDepthShift = 45;
+constexpr int kAlphaShift = 43;
+constexpr int kOpaqueFilterShift = 42;
+constexpr int kOpaqueTexShift = 26;
+constexpr int kBlendDepthShift = 29;
+constexpr int kBlendFilterShift = 28;
+constexpr int kBlendTexShift = 12;
+constexpr uint32_t kMaxTexId = 0xffff;
+
+// Float bits that sort like the value as unsigned integers.
+uint32_t ordered_bits(float f) {
+    const uint32_t u = std::bit_cast<uint32_t>(f);
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// Stable LSD radix sort by key, a byte per pass. Passes where every key has the same byte are
+// skipped, which is most of them: the layer/blend bits and, for opaque draws, the low bits
+// above the texture are mostly constant.
+template <typename Entry> void radix_sort(std::vector<Entry>& a, std::vector<Entry>& tmp) {
+    const size_t n = a.size();
+    if (n < 2)
+        return;
+    uint32_t count[8][256];
+    std::memset(count, 0, sizeof(count));
+    for (const Entry& e : a) {
+        for (int b = 0; b < 8; ++b)
+            ++count[b][(e.key >> (8 * b)) & 0xff];
+    }
+    tmp.resize(n);
+    for (int b = 0; b < 8; ++b) {
+        uint32_t* c = count[b];
+        if (c[(a[0].key >> (8 * b)) & 0xff] == n)
+            continue;
+        uint32_t sum = 0;
+        for (int i = 0; i < 256; ++i) {
+            const uint32_t k = c[i];
+            c[i] = sum;
+            sum += k;
+        }
+        for (const Entry& e : a)
+            tmp[c[(e.key >> (8 * b)) & 0xff]++] = e;
+        a.swap(tmp);
+    }
+}
+
+} // namespace
+
+uint32_t RenderQueue::Recorder::add_mesh(const Renderer& renderer, const sr::assets::Mesh& mesh,
+                                         const sr::math::Mat4& model, bool vertices) {
+    if (mesh_count_ == meshes_.size())
+        meshes_.emplace_back();
+    if (vertices)
+        renderer.prepare_mesh(mesh, model, queue_->cam_, meshes_[mesh_count_]);
+    else
+        renderer.begin_mesh(mesh, model, queue_->cam_, meshes_[mesh_count_]);
+    return mesh_count_++;
+}
+
+void RenderQueue::Recorder::prepare_vertices(const Renderer& renderer, uint32_t mesh,
+                                             const uint32_t* vertices, size_t count) {
+    renderer.prepare_vertices(meshes_[mesh], vertices, count);
+}
+
+void RenderQueue::Recorder::push(const Item& item, const sr::math::Vec3& center, float radius) {
+    Command c;
+    c.item = item;
+    record(c, item.alpha_mode == sr::assets::AlphaMode::Blend, item.layer, center, radius);
+}
+
+void RenderQueue::Recorder::push_instances(const Renderer::InstanceBatch& batch,
+                                           const sr::math::Vec3& center, float radius,
+                                           uint8_t layer) {
+    if (!batch.model || !batch.draws || batch.count == 0)
+        return;
+    // Each pass is keyed by the material of its first primitive.
+    const Renderer::DrawParams* opaque = nullptr;
+    const Renderer::DrawParams* blend = nullptr;
+    for (size_t p = 0; p < batch.model->primitives.size(); ++p) {
+        const Renderer::DrawParams& d = batch.draws[p];
+        if (!d.tex)
+            continue;
+        const Renderer::DrawParams*& first =
+            d.alpha_mode == sr::assets::AlphaMode::Blend ? blend : opaque;
+        if (!first)
+            first = &d;
+    }
+    for (const Renderer::DrawParams* d : {opaque, blend}) {
+        if (!d)
+            continue;
+        Command c;
+        c.batch = &batch;
+        c.item.tex = d->tex;
+        c.item.alpha_mode = d->alpha_mode;
+        c.item.filter = d->filter;
+        record(c, d == blend, layer, center, radius);
+    }
+}
+
+void RenderQueue::Recorder::record(Command& c, bool blend, uint8_t layer,
+                                   const sr::math::Vec3& center, float radius) {
+    // View space looks down -z.
+    const sr::math::Mat4& view = queue_->view_;
+    const float depth = -(view.m[2][0] * center.x + view.m[2][1] * center.y +
+                          view.m[2][2] * center.z + view.m[2][3]);
+    const uint64_t linear = c.item.filter == sr::assets::TextureFilter::Linear;
+    uint64_t key = uint64_t(layer & 3) << kLayerShift;
+    if (blend) {
+        key |= 1ull << kBlendShift;
+        key |= uint64_t(~ordered_bits(depth)) << kBlendDepthShift;
+        key |= linear << kBlendFilterShift;
+    } else {
+        key |= uint64_t(ordered_bits(depth - radius) >> 16) << kOpaqueDepthShift;
+        key |= uint64_t(c.item.alpha_mode) << kAlphaShift;
+        key |= linear << kOpaqueFilterShift;
+    }
+    c.key = key;
+    commands_.push_back(c);
+}
+
+void RenderQueue::set_recorder_count(int count) {
+    recorders_.resize(size_t(std::max(count, 1)));
+}
+
+void RenderQueue::begin(const Camera& cam) {
+    cam_ = cam;
+    view_ = sr::math::Mat4::look_at(cam.eye, cam.target, cam.up);
+    for (Recorder& r : recorders_) {
+        r.queue_ = this;
+        r.mesh_count_ = 0;
+        r.commands_.clear();
+    }
+}
+
+uint32_t RenderQueue::texture_id(const sr::gfx::Texture* tex) {
+    const size_t mask = tex_slots_.size() - 1;
+    size_t i = (std::bit_cast<uintptr_t>(tex) >> 4) * 0x9e3779b97f4a7c15ull >> 32 & mask;
+    for (;; i = (i + 1) & mask) {
+        TextureSlot& s = tex_slots_[i];
+        if (s.frame != tex_frame_) {
+            s.tex = tex;
+            s.frame = tex_frame_;
+            s.id = std::min(tex_count_++, kMaxTexId);
+            return s.id;
+        }
+        if (s.tex == tex)
+            return s.id;
+    }
+}
+
+void RenderQueue::submit(Renderer& renderer) {
+    size_t total = 0;
+    for (const Recorder& r : recorders_)
+        total += r.commands_.size();
+    // At most one new texture per command: keep the table under half full.
+    const size_t slots = std::bit_ceil(std::max<size_t>(2 * total, 64));
+    if (tex_slots_.size() < slots) {
+        tex_slots_.assign(slots, TextureSlot{});
+        tex_frame_ = 0;
+    }
+    if (++tex_frame_ == 0) {
+        std::fill(tex_slots_.begin(), tex_slots_.end(), TextureSlot{});
+        tex_frame_ = 1;
+    }
+    tex_count_ = 0;
+
+    // Without sorting only the pass bits stay, so the stable sort keeps record order within
+    // each pass.
+    sorted_.clear();
+    for (size_t r = 0; r < recorders_.size(); ++r) {
+        const std::vector<Recorder::Command>& commands = recorders_[r].commands_;
+        for (size_t i = 0; i < commands.size(); ++i) {
+            const Recorder::Command& c = commands[i];
+            uint64_t key = c.key;
+            if (!sorting_) {
+                key &= kPassMask;
+            } else {
+                const bool blend = (key >> kBlendShift) & 1;
+                key |= uint64_t(texture_id(c.item.tex))
+                       << (blend ? kBlendTexShift : kOpaqueTexShift);
+            }
+            sorted_.push_back(SortEntry{key, uint32_t(r), uint32_t(i)});
+        }
+    }
+    radix_sort(sorted_, sort_tmp_);
+
+    const uint64_t before = renderer.fragments_shaded();
+    stats_.opaque_draws = 0;
+    stats_.blend_draws = 0;
+    stats_.texture_changes = 0;
+    const sr::gfx::Texture* bound = nullptr;
+    for (const SortEntry& e : sorted_) {
+        const Recorder& r = recorders_[e.recorder];
+        const Recorder::Command& c = r.commands_[e.command];
+        const bool blended = (e.key >> kBlendShift) & 1;
+        ++(blended ? stats_.blend_draws : stats_.opaque_draws);
+        if (c.item.tex != bound) {
+            stats_.texture_changes += bound != nullptr;
+            bound = c.item.tex;
+        }
+        if (c.batch) {
+            renderer.draw_instances(*c.batch, cam_, blended);
+            continue;
+        }
+        const Item& it = c.item;
+        renderer.draw_textured_mesh_prepared(r.meshes_[it.mesh], *it.tex, it.index_offset,
+                                             it.index_count, it.double_sided, it.front_face_ccw,
+                                             it.alpha_mode, it.alpha_cutoff, it.filter);
+    }
+    renderer.flush();
+
+    stats_.fragments_shaded = renderer.fragments_shaded() - before;
+}
+
+} // namespace sr::render
@@ -1,5 +1,9 @@
 #include "sr/render/renderer.hpp"
 
+#include "sr/math/transform.hpp"
+#include "sr/render/cluster_cull.hpp"
+#include "sr/render/frustum.hpp"
+
 #include <algorithm>
 #include <cmath>
 #include <cstring>
@@ -8,135 +12,229 @@
 namespace sr::render {
 namespace {
 
-inline float edge_fn(float ax, float ay, float bx, float by, float px, float py) {
-    return (px - ax) * (by - ay) - (py - ay) * (bx - ax);
-}
-
 template <typename DistFn>
-static std::vector<detail::ClipVert>
-clip_poly_against_plane(const std::vector<detail::ClipVert>& poly, DistFn dist_fn) {
-    if (poly.empty())
-        return {};
-    std::vector<detail::ClipVert> out;
-    out.reserve(poly.size() + 2);
-
-    auto prev = poly.back();
-    float prev_d = dist_fn(prev.clip);
+static void clip_poly_against_plane(const detail::ClipPoly& poly, detail::ClipPoly& out,
+                                    DistFn dist_fn) {
+    out.count = 0;
+    if (poly.count == 0)
+        return;
+
+    // Each edge emits at most two vertices and a convex polygon gains at most one per plane, so
+    // out stays within kMaxClipVerts. Float error (nearly collinear vertices, NaN distances) can
+    // break that convexity; the polygon is then dropped rather than written past the array.
+    bool overflow = false;
+    auto emit = [&]() -> detail::ClipVert* {
+        if (out.count == detail::kMaxClipVerts) {
+            overflow = true;
+            return nullptr;
+        }
+        return &out.v[out.count++];
+    };
+    auto emit_intersection = [&](const detail::ClipVert& prev, const detail::ClipVert& cur,
+                                 float prev_d, float cur_d) {
+        float denom = (prev_d - cur_d);
+        if (denom != 0.0f) {
+            float t = prev_d / denom;
+            if (detail::ClipVert* i = emit()) {
+                i->clip = prev.clip + (cur.clip - prev.clip) * t;
+                i->uv = prev.uv + (cur.uv - prev.uv) * t;
+            }
+        }
+    };
+    auto emit_vertex = [&](const detail::ClipVert& v) {
+        if (detail::ClipVert* o = emit())
+            *o = v;
+    };
+
+    const detail::ClipVert* prev = &poly.v[poly.count - 1];
+    float prev_d = dist_fn(prev->clip);
     bool prev_in = prev_d >= 0.0f;
 
-    for (const auto& cur : poly) {
+    for (int k = 0; k < poly.count; ++k) {
+        const detail::ClipVert& cur = poly.v[k];
         float cur_d = dist_fn(cur.clip);
         bool cur_in = cur_d >= 0.0f;
 
         if (prev_in && cur_in) {
-            out.push_back(cur);
+            emit_vertex(cur);
         } else if (prev_in && !cur_in) {
-            float denom = (prev_d - cur_d);
-            if (denom != 0.0f) {
-                float t = prev_d / denom;
-                detail::ClipVert i;
-                i.clip = prev.clip + (cur.clip - prev.clip) * t;
-                i.uv = prev.uv + (cur.uv - prev.uv) * t;
-                out.push_back(i);
-            }
+            emit_intersection(*prev, cur, prev_d, cur_d);
         } else if (!prev_in && cur_in) {
-            float denom = (prev_d - cur_d);
-            if (denom != 0.0f) {
-                float t = prev_d / denom;
-                detail::ClipVert i;
-                i.clip = prev.clip + (cur.clip - prev.clip) * t;
-                i.uv = prev.uv + (cur.uv - prev.uv) * t;
-                out.push_back(i);
-            }
-            out.push_back(cur);
+            emit_intersection(*prev, cur, prev_d, cur_d);
+            emit_vertex(cur);
         }
 
-        prev = cur;
+        prev = &cur;
         prev_d = cur_d;
         prev_in = cur_in;
     }
-
-    return out;
+    if (overflow)
+        out.count = 0;
 }
 
 } // namespace
 
 void Renderer::clear(uint32_t argb, float z) {
-    fb_.clear(argb);
-    zb_.clear(z);
+    reset_bins();
+    fragments_ = 0;
+    clear_argb_ = argb;
+    clear_z_ = z;
+    tile_clear_.assign(size_t(tiles_x_) * size_t(tiles_y_), 1);
+    if (vis_)
+        vis_ids_.resize(size_t(fb_.width()) * size_t(fb_.height()));
 }
 
-std::vector<detail::ClipVert> Renderer::clip_triangle(std::vector<detail::ClipVert> poly) {
-    // Clip volume (OpenGL): -w<=x<=w, -w<=y<=w, -w<=z<=w
+int Renderer::clip_triangle(const detail::ClipVert& v0, const detail::ClipVert& v1,
+                            const detail::ClipVert& v2, uint8_t planes, float far_w,
+                            detail::ClipPoly& out) {
+    // Clip volume (OpenGL): -w<=x<=w, -w<=y<=w, -w<=z<=w (z<=0 at the far plane for ReverseZ)
     const auto left = [](const sr::math::Vec4& c) { return c.x + c.w; };
     const auto right = [](const sr::math::Vec4& c) { return -c.x + c.w; };
     const auto bottom = [](const sr::math::Vec4& c) { return c.y + c.w; };
     const auto top = [](const sr::math::Vec4& c) { return -c.y + c.w; };
     const auto nearp = [](const sr::math::Vec4& c) { return c.z + c.w; };
-    const auto farp = [](const sr::math::Vec4& c) { return -c.z + c.w; };
-
-    poly = clip_poly_against_plane(poly, left);
-    if (poly.size() < 3)
-        return {};
-    poly = clip_poly_against_plane(poly, right);
-    if (poly.size() < 3)
-        return {};
-    poly = clip_poly_against_plane(poly, bottom);
-    if (poly.size() < 3)
-        return {};
-    poly = clip_poly_against_plane(poly, top);
-    if (poly.size() < 3)
-        return {};
-    poly = clip_poly_against_plane(poly, nearp);
-    if (poly.size() < 3)
-        return {};
-    poly = clip_poly_against_plane(poly, farp);
-    if (poly.size() < 3)
-        return {};
-    return poly;
+    const auto farp = [far_w](const sr::math::Vec4& c) { return -c.z + far_w * c.w; };
+
+    // Ping-pong between `out` and one scratch polygon, both on the caller's/our stack.
+    detail::ClipPoly scratch;
+    detail::ClipPoly* src = &out;
+    detail::ClipPoly* dst = &scratch;
+    out.v[0] = v0;
+    out.v[1] = v1;
+    out.v[2] = v2;
+    out.count = 3;
+
+    auto apply = [&](uint8_t bit, auto dist_fn) {
+        if (!(planes & bit) || src->count < 3)
+            return;
+        clip_poly_against_plane(*src, *dst, dist_fn);
+        std::swap(src, dst);
+    };
+    apply(detail::kClipLeft, left);
+    apply(detail::kClipRight, right);
+    apply(detail::kClipBottom, bottom);
+    apply(detail::kClipTop, top);
+    apply(detail::kClipNear, nearp);
+    apply(detail::kClipFar, farp);
+
+    if (src != &out)
+        out = *src;
+    if (out.count < 3)
+        out.count = 0;
+    return out.count;
 }
 
 void Renderer::draw_textured_mesh(const sr::assets::Mesh& mesh, const sr::gfx::Texture& tex,
                                   const sr::math::Mat4& model, const Camera& cam,
                                   uint32_t index_offset, uint32_t index_count, bool double_sided,
                                   bool front_face_ccw, sr::assets::AlphaMode alpha_mode,
-                                  float alpha_cutoff) {
+                                  float alpha_cutoff, sr::assets::TextureFilter filter) {
     auto prepared = prepare_mesh(mesh, model, cam);
     draw_textured_mesh_prepared(prepared, tex, index_offset, index_count, double_sided,
-                                front_face_ccw, alpha_mode, alpha_cutoff);
+                                front_face_ccw, alpha_mode, alpha_cutoff, filter);
 }
 
 Renderer::PreparedMesh Renderer::prepare_mesh(const sr::assets::Mesh& mesh,
                                               const sr::math::Mat4& model,
                                               const Camera& cam) const {
-    const float aspect = float(fb_.width()) / float(fb_.height());
-    sr::math::Mat4 view = sr::math::Mat4::look_at(cam.eye, cam.target, cam.up);
-    sr::math::Mat4 proj = sr::math::Mat4::perspective(cam.fov_y_rad, aspect, cam.z_near, cam.z_far);
-    sr::math::Mat4 vp = sr::math::mul(proj, view);
-    sr::math::Mat4 mvp = sr::math::mul(vp, model);
-
     PreparedMesh prepared;
+    prepare_mesh(mesh, model, cam, prepared);
+    return prepared;
+}
+
+void Renderer::prepare_mesh(const sr::assets::Mesh& mesh, const sr::math::Mat4& model,
+                            const Camera& cam, PreparedMesh& prepared) const {
+    begin_mesh(mesh, model, cam, prepared);
+    transform_vertices<false>(prepared, nullptr, mesh.positions.size());
+}
+
+void Renderer::begin_mesh(const sr::assets::Mesh& mesh, const sr::math::Mat4& model,
+                          const Camera& cam, PreparedMesh& prepared) const {
+    begin_mesh_mvp(mesh, sr::math::mul(view_proj(cam, frame_aspect()), model),
+                   detail::far_w(cam.depth_mapping), prepared);
+}
+
+void Renderer::begin_mesh_mvp(const sr::assets::Mesh& mesh, const sr::math::Mat4& mvp,
+                              float far_w, PreparedMesh& prepared) const {
     prepared.mesh = &mesh;
+    prepared.mvp = mvp;
     prepared.has_uv = !mesh.uvs.empty() && mesh.uvs.size() == mesh.positions.size();
+    prepared.far_w = far_w;
+
+    const size_t n = mesh.positions.size();
+    prepared.clip_pos.resize(n);
+    prepared.screen.resize(n);
+    prepared.outcode.resize(n);
+    // A new pass number invalidates every mark; on wrap-around the marks are cleared for real.
+    if (++prepared.pass == 0) {
+        std::fill(prepared.done_pass.begin(), prepared.done_pass.end(), 0u);
+        prepared.pass = 1;
+    }
+    prepared.done_pass.resize(n, 0u);
+}
 
-    prepared.clip_pos.reserve(mesh.positions.size());
-    for (const auto& p : mesh.positions) {
-        prepared.clip_pos.push_back(sr::math::mul(mvp, sr::math::Vec4{p.x, p.y, p.z, 1.0f}));
+void Renderer::prepare_vertices(PreparedMesh& prepared, const uint32_t* vertices,
+                                size_t count) const {
+    transform_vertices<true>(prepared, vertices, count);
+}
+
+template <bool Listed>
+void Renderer::transform_vertices(PreparedMesh& prepared, const uint32_t* list,
+                                  size_t count) const {
+    constexpr uint8_t kNeedsClip = detail::kClipNear | detail::kClipFar | detail::kClipGuard;
+    const sr::assets::Mesh& mesh = *prepared.mesh;
+    for (size_t k = 0; k < count; ++k) {
+        size_t i = k;
+        if constexpr (Listed) {
+            i = list[k];
+            if (prepared.done_pass[i] == prepared.pass)
+                continue;
+            prepared.done_pass[i] = prepared.pass;
+        }
+        const auto& p = mesh.positions[i];
+        const sr::math::Vec4 clip =
+            sr::math::mul(prepared.mvp, sr::math::Vec4{p.x, p.y, p.z, 1.0f});
+        const uint8_t code = detail::clip_outcode(clip, prepared.far_w);
+        prepared.clip_pos[i] = clip;
+        prepared.outcode[i] = code;
+        // Vertices past near/far (including w <= 0, which always trips near) or the guard band
+        // only ever reach the raster through the clipper, so their screen record is never read.
+        if (!(code & kNeedsClip))
+            prepared.screen[i] =
+                to_screen(clip, prepared.has_uv ? mesh.uvs[i] : sr::math::Vec2{0, 0});
     }
+}
 
-    return prepared;
+Renderer::ScreenVert Renderer::to_screen(const sr::math::Vec4& clip,
+                                         const sr::math::Vec2& uv) const {
+    // Perspective divide -> NDC -> pixels (y down).
+    const float invw = 1.0f / clip.w;
+    const float ndc_x = clip.x * invw;
+    const float ndc_y = clip.y * invw;
+    ScreenVert sv;
+    sv.x = (ndc_x * 0.5f + 0.5f) * float(fb_.width() - 1);
+    if (field_ < 0) {
+        sv.y = (1.0f - (ndc_y * 0.5f + 0.5f)) * float(fb_.height() - 1);
+    } else {
+        // Frame row 2k + parity, centre 2k + parity + 0.5, lands on field row k, centre k + 0.5.
+        const float frame_y = (1.0f - (ndc_y * 0.5f + 0.5f)) * float(frame_height() - 1);
+        sv.y = (frame_y - float(field_)) * 0.5f + 0.25f;
+    }
+    sv.z = clip.z * invw;
+    sv.inv_w = invw;
+    sv.u_over_w = uv.x * invw;
+    sv.v_over_w = uv.y * invw;
+    return sv;
 }
 
 void Renderer::draw_textured_mesh_prepared(const PreparedMesh& prepared,
                                            const sr::gfx::Texture& tex, uint32_t index_offset,
                                            uint32_t index_count, bool double_sided,
                                            bool front_face_ccw, sr::assets::AlphaMode alpha_mode,
-                                           float alpha_cutoff) {
+                                           float alpha_cutoff, sr::assets::TextureFilter filter) {
     if (!prepared.mesh)
         return;
     const sr::assets::Mesh& mesh = *prepared.mesh;
-    const auto& clip_pos = prepared.clip_pos;
-    const bool has_uv = prepared.has_uv;
 
     // Triangles.
     const uint32_t idx_base = index_offset;
@@ -146,168 +244,237 @@ void Renderer::draw_textured_mesh_prepared(const PreparedMesh& prepared,
     if (idx_base >= mesh.indices.size())
         return;
     uint32_t end = std::min<uint32_t>(uint32_t(mesh.indices.size()), idx_base + count);
-    for (uint32_t i = idx_base; i + 2 < end; i += 3) {
+
+    DrawParams params;
+    params.tex = &tex;
+    params.double_sided = double_sided;
+    params.front_face_ccw = front_face_ccw;
+    params.alpha_mode = alpha_mode;
+    params.alpha_cutoff = alpha_cutoff;
+    params.filter = filter;
+    DrawState ds;
+    const uint32_t state = bind_draw_state(params, ds);
+    draw_prepared(prepared, params, idx_base, end, ds, state);
+}
+
+uint32_t Renderer::bind_draw_state(const DrawParams& params, DrawState& ds) {
+    const sr::gfx::Texture& tex = *params.tex;
+    ds.st.tex = &tex;
+    ds.st.alpha_mode = params.alpha_mode;
+    ds.st.alpha_cut = raster::alpha_cut_from_cutoff(params.alpha_cutoff);
+    const int mode = int(params.alpha_mode) < kAlphaModeCount ? int(params.alpha_mode) : 0;
+    ds.sampler = raster::sampler_for(tex, params.filter);
+    const int sampler = int(ds.sampler);
+    ds.kernel = kernels_[mode][sampler];
+    if (vis_ && params.alpha_mode != sr::assets::AlphaMode::Blend)
+        ds.kernel = vis_kernels_[mode][sampler];
+
+    // States live until flush(): binned and deferred (visibility) triangles refer to them.
+    const uint32_t state = uint32_t(bin_states_.size());
+    if (pool_ || vis_) {
+        if (bins_.empty())
+            reset_bins();
+        bin_states_.push_back(ds);
+    }
+    if (vis_ && vis_ids_.size() != size_t(fb_.width()) * size_t(fb_.height()))
+        vis_ids_.assign(size_t(fb_.width()) * size_t(fb_.height()), 0u);
+    return state;
+}
+
+void Renderer::draw_prepared(const PreparedMesh& prepared, const DrawParams& params,
+                             uint32_t begin, uint32_t end, const DrawState& ds, uint32_t state) {
+    const Cull cull = params.double_sided ? Cull::None
+                                          : (params.front_face_ccw ? Cull::BackCcw : Cull::BackCw);
+    (this->*draw_range_for(cull, prepared.has_uv))(prepared, begin, end, ds, state);
+}
+
+void Renderer::draw_instances(const InstanceBatch& batch, const Camera& cam, bool blended) {
+    if (!batch.model || !batch.transforms || !batch.draws)
+        return;
+    const sr::assets::Model& model = *batch.model;
+    const sr::assets::Mesh& mesh = model.mesh;
+    const size_t prims = model.primitives.size();
+    const uint32_t n_indices = uint32_t(mesh.indices.size());
+
+    // Per primitive, once for all instances: which ones this pass draws, and their state.
+    instance_ds_.resize(prims);
+    instance_state_.assign(prims, UINT32_MAX);
+    bool any = false;
+    for (size_t p = 0; p < prims; ++p) {
+        const DrawParams& d = batch.draws[p];
+        if (!d.tex || (d.alpha_mode == sr::assets::AlphaMode::Blend) != blended ||
+            d.index_offset >= n_indices)
+            continue;
+        instance_state_[p] = bind_draw_state(d, instance_ds_[p]);
+        any = true;
+    }
+    if (!any)
+        return;
+
+    const sr::math::Mat4 vp = view_proj(cam, frame_aspect());
+    const Frustum fr = Frustum::from_view_proj(vp, cam.depth_mapping);
+    const float far_w = detail::far_w(cam.depth_mapping);
+    const bool clustered = !model.clusters.empty();
+    PreparedMesh& pm = instance_mesh_;
+
+    for (size_t i = 0; i < batch.count; ++i) {
+        const sr::math::Mat4& xf = batch.transforms[i];
+        const float scale = sr::math::max_scale_component(xf);
+        if (!fr.sphere_visible(sr::math::transform_point(xf, model.bounds_center),
+                               model.bounds_radius * scale))
+            continue;
+
+        begin_mesh_mvp(mesh, sr::math::mul(vp, xf), far_w, pm);
+        if (!clustered)
+            transform_vertices<false>(pm, nullptr, mesh.positions.size());
+        const ClusterView view = clustered ? cluster_view(fr, xf, cam.eye) : ClusterView{};
+
+        for (size_t p = 0; p < prims; ++p) {
+            if (instance_state_[p] == UINT32_MAX)
+                continue;
+            const sr::assets::Primitive& prim = model.primitives[p];
+            if (!fr.sphere_visible(sr::math::transform_point(xf, prim.bounds_center),
+                                   prim.bounds_radius * scale))
+                continue;
+            const DrawParams& d = batch.draws[p];
+            const uint32_t count = d.index_count == 0 ? n_indices : d.index_count;
+            const uint32_t end = std::min<uint32_t>(n_indices, d.index_offset + count);
+            if (!clustered) {
+                draw_prepared(pm, d, d.index_offset, end, instance_ds_[p], instance_state_[p]);
+                continue;
+            }
+            for_each_visible_run(
+                view, model, prim, d.double_sided, d.front_face_ccw, d.index_offset, end,
+                [&](const uint32_t* list, uint32_t n) { transform_vertices<true>(pm, list, n); },
+                [&](uint32_t first, uint32_t last) {
+                    draw_prepared(pm, d, first, last, instance_ds_[p], instance_state_[p]);
+                });
+        }
+    }
+}
+
+Renderer::DrawRangeFn Renderer::draw_range_for(Cull cull, bool has_uv) {
+    static constexpr DrawRangeFn kTable[3][2] = {
+        {&Renderer::draw_range<Cull::None, false>, &Renderer::draw_range<Cull::None, true>},
+        {&Renderer::draw_range<Cull::BackCcw, false>, &Renderer::draw_range<Cull::BackCcw, true>},
+        {&Renderer::draw_range<Cull::BackCw, false>, &Renderer::draw_range<Cull::BackCw, true>},
+    };
+    return kTable[int(cull)][has_uv ? 1 : 0];
+}
+
+template <Renderer::Cull C, bool HasUv>
+void Renderer::draw_range(const PreparedMesh& prepared, uint32_t begin, uint32_t end,
+                          const DrawState& ds, uint32_t state) {
+    const sr::assets::Mesh& mesh = *prepared.mesh;
+    const auto& clip_pos = prepared.clip_pos;
+    const auto& screen_pos = prepared.screen;
+    const auto& outcode = prepared.outcode;
+
+    for (uint32_t i = begin; i + 2 < end; i += 3) {
         uint32_t i0 = mesh.indices[i + 0];
         uint32_t i1 = mesh.indices[i + 1];
         uint32_t i2 = mesh.indices[i + 2];
         if (i0 >= clip_pos.size() || i1 >= clip_pos.size() || i2 >= clip_pos.size())
             continue;
 
-        detail::ClipVert v0{clip_pos[i0], has_uv ? mesh.uvs[i0] : sr::math::Vec2{0, 0}};
-        detail::ClipVert v1{clip_pos[i1], has_uv ? mesh.uvs[i1] : sr::math::Vec2{0, 0}};
-        detail::ClipVert v2{clip_pos[i2], has_uv ? mesh.uvs[i2] : sr::math::Vec2{0, 0}};
+        // Outcodes: reject triangles entirely outside one plane. Inside the guard band only the
+        // near/far planes need real clipping (X/Y overhang is handled by the raster scissor), and
+        // the common fully-inside triangle just gathers its three cached screen vertices.
+        const uint8_t c0 = outcode[i0];
+        const uint8_t c1 = outcode[i1];
+        const uint8_t c2 = outcode[i2];
+        if (c0 & c1 & c2 & detail::kClipFrustum)
+            continue;
+        const uint8_t any = c0 | c1 | c2;
+        const uint8_t planes = (any & detail::kClipGuard)
+                                   ? uint8_t(any & detail::kClipFrustum)
+                                   : uint8_t(any & (detail::kClipNear | detail::kClipFar));
+        if (planes == 0) {
+            submit_triangle<C>(screen_pos[i0], screen_pos[i1], screen_pos[i2], ds, state);
+            continue;
+        }
 
-        auto poly = clip_triangle({v0, v1, v2});
-        if (poly.size() < 3)
+        auto clip_vert = [&](uint32_t vi) {
+            if constexpr (HasUv)
+                return detail::ClipVert{clip_pos[vi], mesh.uvs[vi]};
+            else
+                return detail::ClipVert{clip_pos[vi], sr::math::Vec2{0, 0}};
+        };
+        detail::ClipPoly poly;
+        if (clip_triangle(clip_vert(i0), clip_vert(i1), clip_vert(i2), planes, prepared.far_w,
+                          poly) < 3)
             continue;
 
         // Fan triangulate.
-        const detail::ClipVert vbase = poly[0];
-        for (size_t k = 1; k + 1 < poly.size(); ++k) {
-            const detail::ClipVert a = vbase;
-            const detail::ClipVert b = poly[k];
-            const detail::ClipVert c = poly[k + 1];
-
-            // Perspective divide -> NDC.
-            if (a.clip.w == 0.0f || b.clip.w == 0.0f || c.clip.w == 0.0f)
-                continue;
-            float invwa = 1.0f / a.clip.w;
-            float invwb = 1.0f / b.clip.w;
-            float invwc = 1.0f / c.clip.w;
-            sr::math::Vec3 ndc_a{a.clip.x * invwa, a.clip.y * invwa, a.clip.z * invwa};
-            sr::math::Vec3 ndc_b{b.clip.x * invwb, b.clip.y * invwb, b.clip.z * invwb};
-            sr::math::Vec3 ndc_c{c.clip.x * invwc, c.clip.y * invwc, c.clip.z * invwc};
-
-            auto to_screen = [&](const sr::math::Vec3& ndc, float invw,
-                                 const sr::math::Vec2& uv) -> ScreenVert {
-                float sx = (ndc.x * 0.5f + 0.5f) * float(fb_.width() - 1);
-                float sy = (1.0f - (ndc.y * 0.5f + 0.5f)) * float(fb_.height() - 1); // y down
-                ScreenVert sv;
-                sv.x = sx;
-                sv.y = sy;
-                sv.z = ndc.z;
-                sv.inv_w = invw;
-                sv.u_over_w = uv.x * invw;
-                sv.v_over_w = uv.y * invw;
-                return sv;
-            };
-
-            ScreenVert sa = to_screen(ndc_a, invwa, a.uv);
-            ScreenVert sb = to_screen(ndc_b, invwb, b.uv);
-            ScreenVert sc = to_screen(ndc_c, invwc, c.uv);
-
-            // Backface cull in NDC (y up). CCW in NDC is the usual "front-face" convention.
-            float area_ndc = (ndc_b.x - ndc_a.x) * (ndc_c.y - ndc_a.y) -
-                             (ndc_b.y - ndc_a.y) * (ndc_c.x - ndc_a.x);
-            if (!double_sided) {
-                if (front_face_ccw) {
-                    if (area_ndc <= 0.0f)
-                        continue;
-                } else {
-                    if (area_ndc >= 0.0f)
-                        continue;
-                }
-            }
+        bool degenerate = false;
+        for (int k = 0; k < poly.count; ++k)
+            degenerate |= poly.v[k].clip.w == 0.0f;
+        if (degenerate)
+            continue;
+        ScreenVert sv[detail::kMaxClipVerts];
+        for (int k = 0; k < poly.count; ++k)
+            sv[k] = to_screen(poly.v[k].clip, poly.v[k].uv);
+        for (int k = 1; k + 1 < poly.count; ++k)
+            submit_triangle<C>(sv[0], sv[k], sv[k + 1], ds, state);
+    }
+}
 
-            raster_triangle_textured(sa, sb, sc, tex, alpha_mode, alpha_cutoff);
+template <Renderer::Cull C>
+void Renderer::submit_triangle(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                               const DrawState& ds, uint32_t state) {
+    // Backface cull. Screen space is y-down, so CCW in NDC (the usual "front-face" convention)
+    // has negative area here.
+    if constexpr (C != Cull::None) {
+        const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if constexpr (C == Cull::BackCcw) {
+            if (area >= 0.0f)
+                return;
+        } else {
+            if (area <= 0.0f)
+                return;
         }
     }
+
+    if (vis_) {
+        submit_visible(a, b, c, ds, state);
+    } else if (pool_) {
+        bin_triangle(a, b, c, state);
+    } else {
+        const ClipRect screen{0, 0, fb_.width() - 1, fb_.height() - 1};
+        clear_tiles_under(a, b, c);
+        raster_triangle_textured(a, b, c, ds, screen, fragments_);
+    }
 }
 
 void Renderer::raster_triangle_textured(const ScreenVert& a, const ScreenVert& b,
-                                        const ScreenVert& c, const sr::gfx::Texture& tex,
-                                        sr::assets::AlphaMode alpha_mode, float alpha_cutoff) {
-    // Bounding box.
-    float minx_f = std::min({a.x, b.x, c.x});
-    float maxx_f = std::max({a.x, b.x, c.x});
-    float miny_f = std::min({a.y, b.y, c.y});
-    float maxy_f = std::max({a.y, b.y, c.y});
-
-    int minx = std::max(0, int(std::floor(minx_f)));
-    int maxx = std::min(fb_.width() - 1, int(std::ceil(maxx_f)));
-    int miny = std::max(0, int(std::floor(miny_f)));
-    int maxy = std::min(fb_.height() - 1, int(std::ceil(maxy_f)));
-    if (minx > maxx || miny > maxy)
+                                        const ScreenVert& c, const DrawState& ds,
+                                        const ClipRect& rect, uint64_t& fragments,
+                                        uint32_t vis_id) {
+    // Every pixel is evaluated from its own centre, so clipping the box to a tile gives exactly
+    // the pixels the full-screen pass would have produced there.
+    raster::Setup setup;
+    if (!raster::setup_triangle(a, b, c, rect, setup))
         return;
 
-    float area = edge_fn(a.x, a.y, b.x, b.y, c.x, c.y);
-    if (area == 0.0f)
+    raster::Target target;
+    target.color = fb_.pixels();
+    target.depth = zb_.raw();
+    target.depth_format = zb_.format();
+    target.width = fb_.width();
+    target.height = fb_.height();
+    target.color_stride = fb_.stride();
+    target.hiz = zb_.hiz_data();
+    target.hiz_width = zb_.hiz_width();
+    target.fragments = &fragments;
+
+    if (vis_id == 0) {
+        ds.kernel(setup, ds.st, target);
         return;
-    float inv_area = 1.0f / area;
-
-    for (int y = miny; y <= maxy; ++y) {
-        float py = float(y) + 0.5f;
-        for (int x = minx; x <= maxx; ++x) {
-            float px = float(x) + 0.5f;
-            float w0 = edge_fn(b.x, b.y, c.x, c.y, px, py);
-            float w1 = edge_fn(c.x, c.y, a.x, a.y, px, py);
-            float w2 = edge_fn(a.x, a.y, b.x, b.y, px, py);
-
-            // Inside test supports both windings (area sign).
-            if (area > 0.0f) {
-                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
-                    continue;
-            } else {
-                if (w0 > 0.0f || w1 > 0.0f || w2 > 0.0f)
-                    continue;
-            }
-
-            float alpha = w0 * inv_area;
-            float beta = w1 * inv_area;
-            float gamma = w2 * inv_area;
-
-            float z = alpha * a.z + beta * b.z + gamma * c.z;
-            // NDC z: near=-1 is closer than far=+1.
-            if (z >= zb_.get(x, y))
-                continue;
-
-            float invw = alpha * a.inv_w + beta * b.inv_w + gamma * c.inv_w;
-            if (invw == 0.0f)
-                continue;
-            float uow = alpha * a.u_over_w + beta * b.u_over_w + gamma * c.u_over_w;
-            float vow = alpha * a.v_over_w + beta * b.v_over_w + gamma * c.v_over_w;
-            float u = uow / invw;
-            float v = vow / invw;
-
-            uint32_t src = tex.sample_repeat(u, v);
-            uint8_t a8 = uint8_t((src >> 24) & 0xFF);
-
-            if (alpha_mode == sr::assets::AlphaMode::Opaque) {
-                src |= 0xFF000000u;
-                fb_.pixels()[y * fb_.width() + x] = src;
-                zb_.set(x, y, z);
-                continue;
-            }
-
-            if (alpha_mode == sr::assets::AlphaMode::Mask) {
-                const float cutoff = std::clamp(alpha_cutoff, 0.0f, 1.0f);
-                const uint8_t cut = uint8_t(std::lround(cutoff * 255.0f));
-                if (a8 < cut)
-                    continue;
-                src |= 0xFF000000u;
-                fb_.pixels()[y * fb_.width() + x] = src;
-                zb_.set(x, y, z);
-                continue;
-            }
-
-            // Blend (naive): depth-test as usual, then alpha-blend over the existing pixel.
-            if (a8 == 0)
-                continue;
-            uint32_t dst = fb_.pixels()[y * fb_.width() + x];
-            const uint32_t inva = 255u - uint32_t(a8);
-            const uint32_t sr = (src >> 16) & 0xFFu;
-            const uint32_t sg = (src >> 8) & 0xFFu;
-            const uint32_t sb = (src)&0xFFu;
-            const uint32_t dr = (dst >> 16) & 0xFFu;
-            const uint32_t dg = (dst >> 8) & 0xFFu;
-            const uint32_t db = (dst)&0xFFu;
-            const uint32_t or_ = (sr * uint32_t(a8) + dr * inva) / 255u;
-            const uint32_t og_ = (sg * uint32_t(a8) + dg * inva) / 255u;
-            const uint32_t ob_ = (sb * uint32_t(a8) + db * inva) / 255u;
-            fb_.pixels()[y * fb_.width() + x] = 0xFF000000u | (or_ << 16) | (og_ << 8) | ob_;
-            zb_.set(x, y, z);
-        }
     }
+    target.ids = vis_ids_.data();
+    raster::State st = ds.st;
+    st.vis_id = vis_id;
+    ds.kernel(setup, st, target);
 }
 
 } // namespace sr::render
@@ -0,0 +1,165 @@
+#include "sr/render/renderer.hpp"
+
+#include "sr/platform/worker_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sr::render {
+
+void Renderer::reset_bins() {
+    const int tx = (fb_.width() + kTileSize - 1) / kTileSize;
+    const int ty = (fb_.height() + kTileSize - 1) / kTileSize;
+    if (tx != tiles_x_ || ty != tiles_y_) {
+        tiles_x_ = tx;
+        tiles_y_ = ty;
+        // Only ever grow: with a resizing framebuffer the grid changes often, and spare bins keep
+        // their capacity for when it grows back.
+        const size_t count = size_t(tx) * size_t(ty);
+        if (bins_.size() < count) {
+            bins_.resize(count);
+            tile_fragments_.resize(count, 0);
+        }
+    }
+    // Keep capacity: bins refill to roughly the same size every frame.
+    for (auto& bin : bins_)
+        bin.clear();
+    bin_tris_.clear();
+    bin_states_.clear();
+    vis_tris_.clear();
+    vis_blend_.clear();
+}
+
+bool Renderer::tile_span(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                         ClipRect& tiles) const {
+    // Same conservative box the raster loop uses, so no covered pixel falls outside the span.
+    const int minx = std::max(0, int(std::floor(std::min({a.x, b.x, c.x}))));
+    const int maxx = std::min(fb_.width() - 1, int(std::ceil(std::max({a.x, b.x, c.x}))));
+    const int miny = std::max(0, int(std::floor(std::min({a.y, b.y, c.y}))));
+    const int maxy = std::min(fb_.height() - 1, int(std::ceil(std::max({a.y, b.y, c.y}))));
+    if (minx > maxx || miny > maxy)
+        return false;
+    tiles.x0 = minx / kTileSize;
+    tiles.y0 = miny / kTileSize;
+    tiles.x1 = maxx / kTileSize;
+    tiles.y1 = maxy / kTileSize;
+    return true;
+}
+
+void Renderer::bin_triangle(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                            uint32_t state, uint32_t vis_id) {
+    ClipRect tiles;
+    if (!tile_span(a, b, c, tiles))
+        return;
+
+    const uint32_t idx = uint32_t(bin_tris_.size());
+    bin_tris_.push_back(BinnedTri{a, b, c, state, vis_id});
+    for (int ty = tiles.y0; ty <= tiles.y1; ++ty) {
+        for (int tx = tiles.x0; tx <= tiles.x1; ++tx)
+            bins_[size_t(ty) * size_t(tiles_x_) + size_t(tx)].push_back(idx);
+    }
+}
+
+void Renderer::clear_tile(int t) {
+    if (size_t(t) >= tile_clear_.size() || !tile_clear_[size_t(t)])
+        return;
+    tile_clear_[size_t(t)] = 0;
+    const int x0 = (t % tiles_x_) * kTileSize;
+    const int y0 = (t / tiles_x_) * kTileSize;
+    const int x1 = std::min(fb_.width(), x0 + kTileSize);
+    const int y1 = std::min(fb_.height(), y0 + kTileSize);
+    fb_.clear_rect(x0, y0, x1, y1, clear_argb_);
+    zb_.clear_rect(x0, y0, x1, y1, clear_z_);
+    if (vis_) {
+        for (int y = y0; y < y1; ++y)
+            std::fill_n(vis_ids_.begin() + (size_t(y) * size_t(fb_.width()) + size_t(x0)),
+                        x1 - x0, 0u);
+    }
+}
+
+void Renderer::clear_tiles_under(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c) {
+    ClipRect tiles;
+    if (!tile_span(a, b, c, tiles))
+        return;
+    for (int ty = tiles.y0; ty <= tiles.y1; ++ty) {
+        for (int tx = tiles.x0; tx <= tiles.x1; ++tx)
+            clear_tile(ty * tiles_x_ + tx);
+    }
+}
+
+void Renderer::clear_untouched_tiles() {
+    const int tile_count = int(tile_clear_.size());
+    if (pool_) {
+        pool_->parallel_for(tile_count, [&](int t) { clear_tile(t); });
+    } else {
+        for (int t = 0; t < tile_count; ++t)
+            clear_tile(t);
+    }
+}
+
+void Renderer::flush() {
+    raster_bins();
+    // Tiles no triangle reached still owe their clear (before the resolve reads their ids).
+    clear_untouched_tiles();
+    if (vis_) {
+        resolve_visibility();
+
+        // Blend draws go over the resolved image, still in submission order.
+        const ClipRect screen{0, 0, fb_.width() - 1, fb_.height() - 1};
+        for (const BinnedTri& tri : vis_blend_) {
+            if (pool_)
+                bin_triangle(tri.a, tri.b, tri.c, tri.state);
+            else
+                raster_triangle_textured(tri.a, tri.b, tri.c, bin_states_[tri.state], screen,
+                                         fragments_);
+        }
+        raster_bins();
+    }
+    reset_bins();
+}
+
+void Renderer::raster_bins() {
+    if (bin_tris_.empty())
+        return;
+
+    const int tile_count = tiles_x_ * tiles_y_;
+    auto raster_tile = [&](int t) {
+        const auto& bin = bins_[size_t(t)];
+        if (bin.empty())
+            return;
+        clear_tile(t);
+        const int tx = t % tiles_x_;
+        const int ty = t / tiles_x_;
+        ClipRect rect;
+        rect.x0 = tx * kTileSize;
+        rect.y0 = ty * kTileSize;
+        rect.x1 = std::min(fb_.width(), rect.x0 + kTileSize) - 1;
+        rect.y1 = std::min(fb_.height(), rect.y0 + kTileSize) - 1;
+
+        // Each tile is owned by exactly one worker, so no pixel is ever shared between threads,
+        // and replaying the bin in submission order keeps blending identical to the serial path.
+        for (uint32_t idx : bin) {
+            const BinnedTri& tri = bin_tris_[idx];
+            raster_triangle_textured(tri.a, tri.b, tri.c, bin_states_[tri.state], rect,
+                                     tile_fragments_[size_t(t)], tri.vis_id);
+        }
+    };
+
+    if (pool_) {
+        pool_->parallel_for(tile_count, raster_tile);
+    } else {
+        for (int t = 0; t < tile_count; ++t)
+            raster_tile(t);
+    }
+
+    // Drop the triangles but keep the draw states: deferred Blend triangles still use them.
+    for (auto& bin : bins_)
+        bin.clear();
+    bin_tris_.clear();
+    for (uint64_t& n : tile_fragments_) {
+        fragments_ += n;
+        n = 0;
+    }
+}
+
+} // namespace sr::render
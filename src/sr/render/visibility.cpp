@@ -0,0 +1,108 @@
+#include "sr/render/renderer.hpp"
+
+#include "sr/platform/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace sr::render {
+
+void Renderer::submit_visible(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c,
+                              const DrawState& ds, uint32_t state) {
+    if (ds.st.alpha_mode == sr::assets::AlphaMode::Blend) {
+        vis_blend_.push_back(BinnedTri{a, b, c, state, 0});
+        return;
+    }
+
+    // The planes do not depend on the clip rect, so one full-screen setup serves every tile.
+    const ClipRect screen{0, 0, fb_.width() - 1, fb_.height() - 1};
+    raster::Setup setup;
+    if (!raster::setup_triangle(a, b, c, screen, setup))
+        return;
+
+    VisTri vt;
+    vt.ox = setup.ox;
+    vt.oy = setup.oy;
+    vt.box = setup.box;
+    vt.inv_w = setup.inv_w;
+    vt.u_over_w = setup.u_over_w;
+    vt.v_over_w = setup.v_over_w;
+    vt.tex = ds.st.tex;
+    vt.sampler = ds.sampler;
+    vis_tris_.push_back(vt);
+    const uint32_t vis_id = uint32_t(vis_tris_.size());
+
+    if (pool_) {
+        bin_triangle(a, b, c, state, vis_id);
+    } else {
+        clear_tiles_under(a, b, c);
+        raster_triangle_textured(a, b, c, ds, screen, fragments_, vis_id);
+    }
+}
+
+void Renderer::resolve_visibility() {
+    if (vis_tris_.empty())
+        return;
+
+    const int w = fb_.width();
+    const int h = fb_.height();
+    const uint32_t* ids = vis_ids_.data();
+
+    // One texture fetch per covered pixel. UVs and the block's mip level are rebuilt from the
+    // triangle's planes with the kernels' operation order, so the result matches forward shading
+    // bit for bit.
+    auto resolve_rows = [&](int band) {
+        const int y0 = band * kTileSize;
+        const int y1 = std::min(h, y0 + kTileSize);
+        for (int y = y0; y < y1; ++y) {
+            const uint32_t* id_row = ids + size_t(y) * size_t(w);
+            uint32_t* crow = fb_.row(y);
+            uint32_t lod_id = 0;
+            int lod_bx = -1;
+            int lod = 0;
+            for (int x = 0; x < w; ++x) {
+                const uint32_t id = id_row[x];
+                if (id == 0)
+                    continue;
+                const VisTri& t = vis_tris_[id - 1];
+                const int bx = x / raster::kBlockSize;
+                if (id != lod_id || bx != lod_bx) {
+                    lod = raster::block_lod(*t.tex, t.inv_w, t.u_over_w, t.v_over_w, t.ox, t.oy,
+                                            t.box, bx, y / raster::kBlockSize);
+                    lod_id = id;
+                    lod_bx = bx;
+                }
+                const float dx = (float(x) + 0.5f) - t.ox;
+                const float dy = (float(y) + 0.5f) - t.oy;
+                const float invw = (t.inv_w.base + t.inv_w.ddy * dy) + t.inv_w.ddx * dx;
+                const float uow = (t.u_over_w.base + t.u_over_w.ddy * dy) + t.u_over_w.ddx * dx;
+                const float vow = (t.v_over_w.base + t.v_over_w.ddy * dy) + t.v_over_w.ddx * dx;
+                const float u = uow / invw;
+                const float v = vow / invw;
+                uint32_t texel;
+                switch (t.sampler) {
+                case raster::Sampler::RepeatPow2:
+                    texel = raster::sample<raster::Sampler::RepeatPow2>(*t.tex, u, v, lod);
+                    break;
+                case raster::Sampler::Bilinear:
+                    texel = raster::sample<raster::Sampler::Bilinear>(*t.tex, u, v, lod);
+                    break;
+                case raster::Sampler::Repeat:
+                default:
+                    texel = raster::sample<raster::Sampler::Repeat>(*t.tex, u, v, lod);
+                    break;
+                }
+                crow[x] = texel | 0xFF000000u;
+            }
+        }
+    };
+
+    const int bands = (h + kTileSize - 1) / kTileSize;
+    if (pool_) {
+        pool_->parallel_for(bands, resolve_rows);
+    } else {
+        for (int b = 0; b < bands; ++b)
+            resolve_rows(b);
+    }
+}
+
+} // namespace sr::render
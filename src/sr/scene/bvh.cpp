@@ -0,0 +1,189 @@
+#include "sr/scene/bvh.hpp"
+
+namespace sr::scene {
+namespace {
+
+// Fat-box growth per side, as a fraction of the box's largest extent.
+constexpr float kFatten = 0.1f;
+
+Aabb fatten(const Aabb& box) {
+    const sr::math::Vec3 d = box.hi - box.lo;
+    const float m = kFatten * std::max({d.x, d.y, d.z, 0.0f});
+    const sr::math::Vec3 ext{m, m, m};
+    return Aabb{box.lo - ext, box.hi + ext};
+}
+
+} // namespace
+
+uint32_t Bvh::insert(const Aabb& box, uint32_t value) {
+    const uint32_t leaf = allocate();
+    Node& node = nodes_[leaf];
+    node.box = fatten(box);
+    node.value = value;
+    node.height = 0;
+    insert_leaf(leaf);
+    ++leaf_count_;
+    return leaf;
+}
+
+void Bvh::remove(uint32_t leaf) {
+    remove_leaf(leaf);
+    release(leaf);
+    --leaf_count_;
+}
+
+bool Bvh::update(uint32_t leaf, const Aabb& box) {
+    if (nodes_[leaf].box.contains(box))
+        return false;
+    remove_leaf(leaf);
+    nodes_[leaf].box = fatten(box);
+    insert_leaf(leaf);
+    return true;
+}
+
+void Bvh::clear() {
+    nodes_.clear();
+    root_ = kNull;
+    free_ = kNull;
+    leaf_count_ = 0;
+}
+
+uint32_t Bvh::allocate() {
+    if (free_ == kNull) {
+        nodes_.emplace_back();
+        return uint32_t(nodes_.size() - 1);
+    }
+    const uint32_t n = free_;
+    free_ = nodes_[n].parent;
+    nodes_[n] = Node{};
+    return n;
+}
+
+void Bvh::release(uint32_t n) {
+    nodes_[n].parent = free_;
+    nodes_[n].height = -1;
+    free_ = n;
+}
+
+void Bvh::insert_leaf(uint32_t leaf) {
+    nodes_[leaf].child[0] = kNull;
+    nodes_[leaf].child[1] = kNull;
+    if (root_ == kNull) {
+        root_ = leaf;
+        nodes_[leaf].parent = kNull;
+        return;
+    }
+
+    // Descend towards the sibling whose merged box adds the least surface area, counting the
+    // growth every ancestor inherits; stop where making a new parent here is cheapest.
+    const Aabb box = nodes_[leaf].box;
+    uint32_t n = root_;
+    while (!nodes_[n].leaf()) {
+        const Node& node = nodes_[n];
+        const float area = node.box.surface_area();
+        const float combined = merge(node.box, box).surface_area();
+        const float here = 2.0f * combined;
+        const float inherited = 2.0f * (combined - area);
+        float cost[2];
+        for (int i = 0; i < 2; ++i) {
+            const Node& c = nodes_[node.child[i]];
+            const float grown = merge(box, c.box).surface_area();
+            cost[i] = (c.leaf() ? grown : grown - c.box.surface_area()) + inherited;
+        }
+        if (here < cost[0] && here < cost[1])
+            break;
+        n = cost[0] <= cost[1] ? node.child[0] : node.child[1];
+    }
+
+    const uint32_t sibling = n;
+    const uint32_t old_parent = nodes_[sibling].parent;
+    const uint32_t parent = allocate();
+    Node& p = nodes_[parent];
+    p.parent = old_parent;
+    p.box = merge(box, nodes_[sibling].box);
+    p.height = nodes_[sibling].height + 1;
+    p.child[0] = sibling;
+    p.child[1] = leaf;
+    nodes_[sibling].parent = parent;
+    nodes_[leaf].parent = parent;
+    if (old_parent == kNull) {
+        root_ = parent;
+    } else {
+        Node& op = nodes_[old_parent];
+        op.child[op.child[0] == sibling ? 0 : 1] = parent;
+    }
+    refit_up(old_parent);
+}
+
+void Bvh::remove_leaf(uint32_t leaf) {
+    if (leaf == root_) {
+        root_ = kNull;
+        return;
+    }
+    const uint32_t parent = nodes_[leaf].parent;
+    const uint32_t grand = nodes_[parent].parent;
+    const uint32_t sibling =
+        nodes_[parent].child[0] == leaf ? nodes_[parent].child[1] : nodes_[parent].child[0];
+    nodes_[sibling].parent = grand;
+    if (grand == kNull) {
+        root_ = sibling;
+    } else {
+        Node& g = nodes_[grand];
+        g.child[g.child[0] == parent ? 0 : 1] = sibling;
+    }
+    release(parent);
+    refit_up(grand);
+}
+
+void Bvh::refit_up(uint32_t n) {
+    while (n != kNull) {
+        n = balance(n);
+        Node& node = nodes_[n];
+        const Node& a = nodes_[node.child[0]];
+        const Node& b = nodes_[node.child[1]];
+        node.box = merge(a.box, b.box);
+        node.height = 1 + std::max(a.height, b.height);
+        n = node.parent;
+    }
+}
+
+uint32_t Bvh::balance(uint32_t a) {
+    Node& na = nodes_[a];
+    if (na.leaf() || na.height < 2)
+        return a;
+    const int skew = nodes_[na.child[1]].height - nodes_[na.child[0]].height;
+    if (skew >= -1 && skew <= 1)
+        return a;
+
+    // Rotate the taller child `c` up into a's place; a keeps the shorter child and takes the
+    // shorter of c's children, c keeps the taller one.
+    const int s = skew > 0 ? 1 : 0;
+    const uint32_t c = na.child[s];
+    Node& nc = nodes_[c];
+    const uint32_t f = nc.child[0];
+    const uint32_t g = nc.child[1];
+    const bool f_taller = nodes_[f].height > nodes_[g].height;
+    const uint32_t keep = f_taller ? f : g;
+    const uint32_t give = f_taller ? g : f;
+
+    nc.child[0] = a;
+    nc.child[1] = keep;
+    nc.parent = na.parent;
+    na.parent = c;
+    if (nc.parent == kNull) {
+        root_ = c;
+    } else {
+        Node& up = nodes_[nc.parent];
+        up.child[up.child[0] == a ? 0 : 1] = c;
+    }
+    na.child[s] = give;
+    nodes_[give].parent = a;
+
+    na.box = merge(nodes_[na.child[0]].box, nodes_[na.child[1]].box);
+    na.height = 1 + std::max(nodes_[na.child[0]].height, nodes_[na.child[1]].height);
+    nc.box = merge(na.box, nodes_[keep].box);
+    nc.height = 1 + std::max(na.height, nodes_[keep].height);
+    return c;
+}
+
+} // namespace sr::scene
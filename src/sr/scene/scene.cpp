@@ -0,0 +1,42 @@
+#include "sr/scene/scene.hpp"
+
+#include "sr/math/transform.hpp"
+
+namespace sr::scene {
+
+Aabb entity_bounds(const Entity& ent) {
+    const sr::math::Vec3 c = sr::math::transform_point(ent.transform, ent.model->bounds_center);
+    const float r = ent.model->bounds_radius * sr::math::max_scale_component(ent.transform);
+    const sr::math::Vec3 ext{r, r, r};
+    return Aabb{c - ext, c + ext};
+}
+
+size_t add_entity(Scene& scene, Entity ent) {
+    ent.bvh_leaf = Bvh::kNull;
+    scene.entities.push_back(std::move(ent));
+    const size_t index = scene.entities.size() - 1;
+    update_entity_bounds(scene, index);
+    return index;
+}
+
+void set_entity_transform(Scene& scene, size_t index, const sr::math::Mat4& transform) {
+    scene.entities[index].transform = transform;
+    update_entity_bounds(scene, index);
+}
+
+void update_entity_bounds(Scene& scene, size_t index) {
+    Entity& ent = scene.entities[index];
+    if (!ent.model) {
+        if (ent.bvh_leaf != Bvh::kNull)
+            scene.bvh.remove(ent.bvh_leaf);
+        ent.bvh_leaf = Bvh::kNull;
+        return;
+    }
+    const Aabb box = entity_bounds(ent);
+    if (ent.bvh_leaf == Bvh::kNull)
+        ent.bvh_leaf = scene.bvh.insert(box, uint32_t(index));
+    else
+        scene.bvh.update(ent.bvh_leaf, box);
+}
+
+} // namespace sr::scene